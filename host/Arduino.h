@@ -0,0 +1,55 @@
+#pragma once
+// Host stand-in for the Arduino core (native env only).
+// Provides just enough of the ESP32 Arduino API for the render path to
+// compile and run on Linux for benchmarking.
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <ctime>
+#include <string>
+
+#define OSMOSIS_HOST 1
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// glibc < 2.38 has no strlcpy; newlib on the ESP32 does
+size_t strlcpy(char* dst, const char* src, size_t size);
+
+// Backlight PWM (esp32-hal-ledc) — no-ops on host
+inline void ledcSetup(uint8_t, uint32_t, uint8_t) {}
+inline void ledcAttachPin(uint8_t, uint8_t) {}
+inline void ledcWrite(uint8_t, uint32_t) {}
+
+// Arduino String, reduced to what the firmware calls
+class String : public std::string {
+public:
+    String() = default;
+    String(const char* s) : std::string(s) {}
+    String(const std::string& s) : std::string(s) {}
+    int indexOf(const char* s) const { size_type p = find(s); return p == npos ? -1 : (int)p; }
+};
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* s);
+    size_t println(const char* s = "");
+    void setQuiet(bool quiet) { _quiet = quiet; }
+
+private:
+    bool _quiet = false;
+};
+
+extern HostSerial Serial;
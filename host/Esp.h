@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in for the ESP class (native env only).
+#include <Arduino.h>
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMaxAllocHeap();
+    void restart();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,63 @@
+#pragma once
+// Host stand-in for the Arduino FS layer (native env only).
+// Files live in a directory on the host; see SPIFFS.setRoot(). Partition
+// images kept there (<label>.part, see host/esp_partition.h) are not listed.
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+public:
+    File() = default;
+
+    size_t read(uint8_t* buf, size_t size);
+    int read();
+    int peek();
+    size_t readBytes(char* buf, size_t size) { return read((uint8_t*)buf, size); }
+    size_t write(const uint8_t* buf, size_t size);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    int available();
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close();
+    const char* name() const;
+    bool isDirectory() const;
+    File openNextFile();
+    explicit operator bool() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl;
+    friend class FS;
+};
+
+class FS {
+public:
+    bool begin(bool formatOnFail = false);
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+    size_t totalBytes();
+    size_t usedBytes();
+
+    // Host only: directory that backs "/"
+    void setRoot(const char* dir);
+    const char* root() const { return _root.c_str(); }
+    // Host only: partition size reported by totalBytes()
+    static size_t hostTotalBytes;
+    // Host only: files opened so far (each a name lookup on SPIFFS)
+    static uint32_t hostOpens;
+
+private:
+    std::string hostPath(const char* path) const;
+    std::string _root = "data";
+};
+
+}  // namespace fs
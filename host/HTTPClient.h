@@ -0,0 +1,75 @@
+#pragma once
+// Host stand-in for the ESP32 HTTPClient (native env only).
+// GET requests are served from local directories mounted under URL prefixes
+// with hostMount(), so pack downloads run end to end against a tree on disk.
+// Anything not mounted is refused like an unreachable host.
+//
+// Connections behave like HTTP/1.1 keep-alive over TLS: a GET on a client
+// that is not connected opens a new connection (counted in hostConnects and
+// charged hostHandshakeMs on the virtual clock, see delay()), and with
+// setReuse(true) end() leaves a fully read connection open for the next
+// request. The server knobs below close connections, silently drop them,
+// corrupt bodies or switch to chunked bodies, to exercise the client's
+// recovery paths.
+//
+// Every file is served with an ETag (a hash of its content) and a
+// Last-Modified date (its mtime); a GET whose If-None-Match or, without
+// one, If-Modified-Since still matches is answered 304 with no body.
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <string>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_CONNECTION_LOST    (-5)
+
+enum followRedirects_t {
+    HTTPC_DISABLE_FOLLOW_REDIRECTS,
+    HTTPC_STRICT_FOLLOW_REDIRECTS,
+    HTTPC_FORCE_FOLLOW_REDIRECTS
+};
+
+class HTTPClient {
+public:
+    bool begin(WiFiClient& client, const char* url);
+    void end();
+    void setTimeout(uint16_t) {}
+    void setFollowRedirects(followRedirects_t) {}
+    void useHTTP10(bool) {}
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void collectHeaders(const char* headerKeys[], size_t count) { (void)headerKeys; (void)count; }
+    void addHeader(const String& name, const String& value);  // Only the conditional ones are read
+
+    int GET();
+    int getSize() const { return _size; }
+    String header(const char* name);  // Transfer-Encoding, ETag and Last-Modified
+    String getString();
+    WiFiClient* getStreamPtr() { return _client; }
+
+    // Host only: serve URLs starting with prefix from files under dir
+    static void hostMount(const char* prefix, const char* dir);
+    static void hostUnmountAll();
+    static uint32_t hostRequests;       // GETs issued since start
+    static uint32_t hostConnects;       // Connections (TLS handshakes) opened since start
+    static uint32_t hostHandshakeMs;    // Modelled cost of opening a connection
+    static uint32_t hostRequestMs;      // Modelled round trip per request
+    static uint32_t hostKeepAliveMax;   // Responses per connection before the server closes it (0: no limit)
+    static bool hostSilentClose;        // ...without telling the client, so its next GET fails
+    static bool hostChunked;            // Send bodies with chunked transfer encoding
+    static uint32_t hostNotModified;    // GETs answered 304 since start
+    static uint32_t hostCutEvery;       // Every Nth response stops half-way and the connection closes (0: never)
+    static uint32_t hostCorruptEvery;   // Every Nth response for a URL containing hostCorruptMatch,
+    static const char* hostCorruptMatch;  // ...from the first, has two bytes flipped (0: never)
+    static uint32_t hostCorrupted;      // Responses corrupted since start
+
+private:
+    WiFiClient* _client = nullptr;
+    std::string _url;
+    std::string _content;  // Decoded body, for getString()
+    int _size = -1;
+    bool _reuse = true;
+    bool _chunked = false;
+    std::string _ifNoneMatch;
+    std::string _ifModifiedSince;
+    std::string _etag;          // Of the last response
+    std::string _lastModified;
+};
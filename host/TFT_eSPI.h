@@ -0,0 +1,164 @@
+#pragma once
+// Host stand-in for TFT_eSPI / TFT_eSprite (native env only).
+//
+// TFT_eSPI draws into an in-memory TFT_WIDTH x TFT_HEIGHT RGB565 framebuffer
+// and counts every image push (strips, bytes) so render cost can be measured
+// without a panel. TFT_eSprite keeps its 16-bit buffer byte-swapped exactly
+// like the real library, so code that writes getPointer() directly behaves
+// the same on both targets.
+//
+// Pixel transfers are modelled on an SPI_FREQUENCY bus: synchronous pushes
+// block the CPU for the whole transfer, DMA pushes only block when a new
+// transfer has to wait for the previous one. The blocked time is reported
+// as spiWaitUs, so the gain from overlapping transfers with composition
+// shows up in host benchmarks even though the copy itself is immediate.
+// hostCpuScale stretches host compose time towards ESP32 speeds: 50 by
+// default, a rough estimate of a desktop core against the 240 MHz LX6, so
+// composition is long enough next to a transfer for the overlap to show.
+//
+// Text is not rasterised from real glyph data: each character is drawn as a
+// fixed-size block in the text colour. Layout, clipping and fill cost stay
+// representative; the glyph shapes do not.
+#include <Arduino.h>
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH  240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 40000000
+#endif
+
+// Text datums (same values as TFT_eSPI)
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+// Counters accumulated by the host panel (sprites report into their parent)
+struct TFT_HostStats {
+    uint32_t pushes;        // pushImage/pushImageDMA/pushSprite calls that reached the panel
+    uint32_t dmaPushes;     // ...of which went through pushImageDMA
+    uint64_t pushBytes;     // Bytes that would have crossed SPI
+    uint64_t pixelsDrawn;   // Pixels written by drawing primitives
+    uint64_t spiWaitUs;     // Modelled time the CPU spent blocked on SPI
+    uint32_t dmaHazards;    // Sprite writes into a buffer that DMA was still sending
+};
+
+class TFT_eSPI {
+public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+    virtual ~TFT_eSPI() = default;
+
+    void init();
+    void setRotation(uint8_t r) { _rotation = r; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    // Primitives
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void fillScreen(uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+
+    // Text
+    void setTextDatum(uint8_t datum) { _datum = datum; }
+    void setTextColor(uint16_t fg) { _textFg = fg; _textBg = fg; }
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false) { _textFg = fg; _textBg = bg; (void)bgfill; }
+    int16_t drawString(const char* str, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const char* str, int32_t x, int32_t y);
+    int16_t textWidth(const char* str, uint8_t font);
+    int16_t textWidth(const char* str);
+    void loadFont(const uint8_t* data) { fontLoaded = (data != nullptr); }
+    void unloadFont() { fontLoaded = false; }
+    bool fontLoaded = false;
+
+    // Pushes a block of pixels in sprite byte order (big-endian RGB565)
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data);
+    void setSwapBytes(bool swap) { _swapBytes = swap; }
+    bool getSwapBytes() const { return _swapBytes; }
+
+    // Transactions and DMA
+    void startWrite() {}
+    void endWrite() {}
+    bool initDMA(bool ctrl_cs = false);
+    void deInitDMA() { _dmaEnabled = false; }
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data,
+                      uint16_t* buffer = nullptr);
+    void dmaWait();
+    bool dmaBusy();
+
+    // Host only: make initDMA() fail, to compare against the synchronous path
+    static bool hostDmaSupported;
+    // Host only: how many times slower than the host the modelled CPU is
+    static uint32_t hostCpuScale;
+
+    // Host only: framebuffer access (native RGB565) and counters
+    const uint16_t* framebuffer() const { return _fb.data(); }
+    const TFT_HostStats& stats() const { return _stats; }
+    void resetStats() { _stats = TFT_HostStats(); }
+
+protected:
+    friend class TFT_eSprite;
+
+    // Write an already-clipped span; subclasses redirect into their buffer
+    virtual void writeSpan(int32_t x, int32_t y, int32_t w, uint16_t color);
+
+    int16_t _width;
+    int16_t _height;
+    TFT_HostStats _stats = {};
+
+private:
+    void drawGlyphs(const char* str, int32_t x, int32_t y, uint8_t font);
+    void copyToPanel(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data);
+    uint64_t cpuClockUs() const;
+    void stall(uint64_t us);
+    void waitBus();
+
+    std::vector<uint16_t> _fb;
+    bool _swapBytes = false;
+    bool _dmaEnabled = false;
+    uint64_t _stalledUs = 0;      // Total modelled SPI stalls (never reset)
+    uint64_t _busUntilUs = 0;     // Modelled end of the in-flight DMA transfer
+    const uint16_t* _dmaData = nullptr;  // Buffer of that transfer
+    uint8_t _rotation = 0;
+    uint8_t _datum = TL_DATUM;
+    uint16_t _textFg = TFT_WHITE;
+    uint16_t _textBg = TFT_WHITE;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI* parent);
+    ~TFT_eSprite() override;
+
+    void setColorDepth(int8_t depth) { _depth = depth; }
+    void* createSprite(int16_t w, int16_t h);
+    void deleteSprite();
+    void* getPointer() { return _img; }
+    bool created() const { return _img != nullptr; }
+
+    void fillSprite(uint32_t color);
+    void pushSprite(int32_t x, int32_t y);
+
+protected:
+    void writeSpan(int32_t x, int32_t y, int32_t w, uint16_t color) override;
+
+private:
+    TFT_eSPI* _parent;
+    uint16_t* _img = nullptr;
+    int8_t _depth = 16;
+};
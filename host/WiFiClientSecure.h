@@ -0,0 +1,40 @@
+#pragma once
+// Host stand-in for WiFiClient / WiFiClientSecure (native env only).
+// A client is one connection to the HTTPClient stand-in's server. It holds
+// the response being read and hands it out at most hostSegment bytes per
+// available(), like data trickling in over TCP, so readers that poll
+// without blocking get exercised. The connection stays open between
+// requests until stop() or until the server closes it (see HTTPClient.h).
+#include <Arduino.h>
+#include <string>
+
+class WiFiClient {
+public:
+    virtual ~WiFiClient() = default;
+
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t size);  // Only what available() reported
+    // Open, or closed by the server with response bytes still unread
+    bool connected() const { return (_open && !_closeAfterBody) || _pos < _body.size(); }
+    void stop();
+    void setTimeout(uint32_t) {}
+
+    // Host only: most bytes that "arrive" between two available() calls
+    static size_t hostSegment;
+
+private:
+    friend class HTTPClient;
+    std::string _body;
+    size_t _pos = 0;
+    size_t _ready = 0;            // Bytes of the current segment not read yet
+    bool _open = false;
+    bool _closeAfterBody = false; // Server sent "Connection: close"
+    bool _stale = false;          // Server dropped it without telling the client
+    uint32_t _served = 0;         // Responses on this connection
+};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+};
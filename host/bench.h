@@ -0,0 +1,58 @@
+#pragma once
+// Benchmark sections shared by host/bench_main.cpp
+
+namespace bench {
+    // Per-strip image draw cost, current renderer vs the original per-pixel
+    // drawPixel() path, over every emoji in the SPIFFS root, and again with
+    // them in each format tools/convert_emoji.py writes (v1, v2, palette) on
+    // a scratch assets partition. Also checks the two produce identical
+    // strips and prints the most heap the renderer held. Returns false on
+    // any mismatch.
+    bool runImages(int frames);
+
+    // The ORLE codec over the emoji in the SPIFFS root: checks every file
+    // re-encodes byte for byte (so convert_emoji.py and the decoders agree),
+    // then per format prints total bytes, the time a cold preloadImage()
+    // takes from standalone SPIFFS files and from the assets partition
+    // (averaged over `rounds`), decode throughput off the partition in MB/s
+    // and pixels/us, and the reference decoder's MB/s from memory. Every
+    // load must draw what the reference decodes. Returns false otherwise.
+    bool runCodec(int rounds);
+
+    // Feeds corrupted variants (truncated, damaged headers, tables and
+    // records) of the emoji in the SPIFFS root, in each format, through
+    // imageRenderer::preloadImage(): as a standalone file and on the assets
+    // partition. Each must be accepted exactly when the reference decoder
+    // accepts it, with the same output. Returns false otherwise. Run in
+    // env:native_asan to have ASan and UBSan watch the decoders too.
+    bool fuzzDecoder(int cases);
+
+    // vocabLoader::load() time and peak heap, manifest.json vs vocab.pack,
+    // for a pack built by tools/build_pack.py from every CSV in vocabDir,
+    // plus the RAM the loaded words occupy. Returns false if the two formats
+    // load different words.
+    bool runVocab(const char* vocabDir);
+
+    // Fetches the stand-in server's catalog, loads it back from its SPIFFS
+    // cache and refreshes it (a 304 while unchanged, reloaded once it
+    // changes), then fetches a 48-language catalog sent chunked: its body
+    // is written to SPIFFS a bounded piece per update() and parsed from
+    // there, and the peak heap of that parse is printed next to parsing a
+    // copy of the whole body. Installs the SPIFFS root's pack from that
+    // server through packMgr::update(), timing each step and counting
+    // requests, TLS handshakes and modelled network time: per-file
+    // downloads with and without keep-alive, then the emoji bundle (made by
+    // buildPack) plain, chunked, over dropped connections and cut short, an
+    // install over a network that cuts off every 3rd response, one whose
+    // emoji arrive with bit errors and one resumed after a power loss
+    // part-way through the bundle. Then updates that installed pack (same
+    // pack, another tier, another language, another tier with no storage to
+    // spare), cancels an install part-way and fails one on a missing font.
+    // Returns false if any ends in the wrong state, leaves a partial,
+    // corrupt or stale file behind, lacks one of its emoji or has install
+    // metrics that don't add up; prints one install's metrics record.
+    // Finally times reading the updated device's emoji off the mapped
+    // assets partition against a file per emoji, and fails if the bytes
+    // differ.
+    bool runDownload(const char* buildPack);
+}
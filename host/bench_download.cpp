@@ -0,0 +1,732 @@
+#include "bench.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <SPIFFS.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include <unistd.h>
+#include "asset_store.h"
+#include "esp_partition.h"
+#include "host_heap.h"
+#include "host_net.h"
+#include "pack_manager.h"
+#include "settings_manager.h"
+
+static const char* BASE_URL = "https://www.vcodeworks.dev/api/osmosis";  // As in pack_manager.cpp
+static const uint32_t MAX_STEPS = 1000000;
+static const uint32_t CANCEL_AFTER_EMOJI_STEPS = 40;
+static const uint32_t POWER_LOSS_AFTER_EMOJI_STEPS = 250;
+static const uint32_t CUT_EVERY = 3;   // flaky_network: every 3rd response is cut off
+static const uint32_t LOOP_MS = 10;    // ...and loop() runs every 10 ms so backoffs expire
+static const uint32_t CORRUPT_EVERY = 2;  // corrupt: every other emoji response has flipped bytes
+static const uint8_t LARGE_CATALOG_LANGUAGES = 48;
+static const uint8_t LARGE_CATALOG_TIERS = 5;
+static const int READ_REPEATS = 20;
+// Modelled ESP32 network costs: an mbedTLS handshake and one request round trip
+static const uint32_t HANDSHAKE_MS = 500;
+static const uint32_t REQUEST_MS = 40;
+
+struct DownloadRun {
+    PackDownloadState state = PackDownloadState::Idle;
+    uint32_t steps = 0;
+    double maxStepUs = 0;
+    double totalUs = 0;
+    PackInstallStats stats = {};
+    std::string metrics;  // installStatsJson() record
+};
+
+static std::string readFile(const std::string& path) {
+    std::string out;
+    if (FILE* f = fopen(path.c_str(), "rb")) {
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+        fclose(f);
+    }
+    return out;
+}
+
+static bool writeFile(const std::string& path, const std::string& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fwrite(data.data(), 1, data.size(), f);
+    return fclose(f) == 0;
+}
+
+static bool exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+static std::vector<std::string> listDir(const std::string& dir) {
+    std::vector<std::string> names;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            if (e->d_name[0] != '.') names.push_back(e->d_name);
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static void removeTree(const std::string& path) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) return;
+    if (S_ISDIR(st.st_mode)) {
+        for (const std::string& name : listDir(path)) removeTree(path + "/" + name);
+        rmdir(path.c_str());
+    } else {
+        unlink(path.c_str());
+    }
+}
+
+enum class Bundle : uint8_t { None, Full, Cut };
+
+// Catalog entries of the stand-in server, as driveDownload() indexes them
+struct PackId {
+    const char* lang;
+    uint8_t langIdx;
+    const char* tier;
+    uint8_t tierIdx;
+};
+static const PackId SPANISH_BEGINNER = {"spanish", 0, "beginner", 0};
+static const PackId SPANISH_INTERMEDIATE = {"spanish", 0, "intermediate", 1};
+static const PackId FRENCH_BEGINNER = {"french", 1, "beginner", 0};
+
+// One tier built with build_pack.py from manifest `words`, a python slice of
+// the source manifest's word list. The emoji bundle is kept aside as
+// emoji.bundle.full, see setServer().
+static bool buildTier(const std::string& src, const std::string& server, const PackId& pack,
+                      const char* words, const std::string& buildPack) {
+    std::string langDir = server + "/packs/" + pack.lang;
+    std::string tierDir = langDir + "/" + pack.tier;
+    mkdir(langDir.c_str(), 0755);
+    mkdir(tierDir.c_str(), 0755);
+    std::string cmd = "python3 -c \"import json, sys; m = json.load(open(sys.argv[1])); "
+                      "m['words'] = m['words'][" + std::string(words) + "]; "
+                      "json.dump(m, open(sys.argv[2], 'w'))\" '" + src + "/manifest.json' '" +
+                      tierDir + "/manifest.json' && "
+                      "python3 '" + buildPack + "' --manifest '" + tierDir + "/manifest.json' --output '" +
+                      tierDir + "' --emoji-dir '" + src + "' --font '" + langDir + "/font.vlw' >/dev/null 2>&1";
+    if (system(cmd.c_str()) != 0 ||
+        rename((tierDir + "/emoji.bundle").c_str(), (tierDir + "/emoji.bundle.full").c_str()) != 0) {
+        fprintf(stderr, "[bench] build_pack.py failed for %s/%s\n", pack.lang, pack.tier);
+        return false;
+    }
+    return true;
+}
+
+// Server tree built from the pack in the SPIFFS root: its words as spanish
+// beginner, the second half of them as spanish intermediate, and again all
+// of them as french beginner with a font of its own
+static bool buildServer(const std::string& src, const std::string& server,
+                        const std::string& buildPack) {
+    for (const std::string& d : {server + "/packs", server + "/packs/emoji",
+                                 server + "/packs/spanish", server + "/packs/french"}) {
+        mkdir(d.c_str(), 0755);
+    }
+    std::string font = readFile(src + "/font.vlw");
+    bool ok = writeFile(server + "/catalog.json",
+                        "{\"languages\":["
+                        "{\"id\":\"spanish\",\"name\":\"Spanish\",\"flag\":\"es\",\"tiers\":["
+                        "{\"id\":\"beginner\",\"name\":\"Beginner\",\"words\":100,\"version\":1},"
+                        "{\"id\":\"intermediate\",\"name\":\"Intermediate\",\"words\":50,\"version\":1}]},"
+                        "{\"id\":\"french\",\"name\":\"French\",\"flag\":\"fr\",\"tiers\":["
+                        "{\"id\":\"beginner\",\"name\":\"Beginner\",\"words\":100,\"version\":1}]}]}");
+    ok = ok && writeFile(server + "/packs/spanish/font.vlw", font);
+    ok = ok && writeFile(server + "/packs/french/font.vlw", font + std::string(64, '\0'));
+    for (const std::string& name : listDir(src)) {
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+            ok = ok && writeFile(server + "/packs/emoji/" + name, readFile(src + "/" + name));
+        }
+    }
+    ok = ok && buildTier(src, server, SPANISH_BEGINNER, ":", buildPack);
+    ok = ok && buildTier(src, server, SPANISH_INTERMEDIATE, "len(m['words']) // 2:", buildPack);
+    ok = ok && buildTier(src, server, FRENCH_BEGINNER, ":", buildPack);
+    return ok;
+}
+
+// Copies the files of a flat directory, replacing what `to` held
+static void copyDir(const std::string& from, const std::string& to) {
+    for (const std::string& name : listDir(to)) unlink((to + "/" + name).c_str());
+    for (const std::string& name : listDir(from)) {
+        writeFile(to + "/" + name, readFile(from + "/" + name));
+    }
+}
+
+// The device as flashed over USB from build_pack.py --provision of the pack
+// in src. assets.part is also the name of the host's partition backing file.
+static bool provisionDevice(const std::string& src, const std::string& device,
+                            const std::string& dir, const std::string& buildPack) {
+    mkdir(dir.c_str(), 0755);
+    std::string cmd = "python3 '" + buildPack + "' --manifest '" + src + "/manifest.json' --output '" +
+                      dir + "' --emoji-dir '" + src + "' --font '" + src + "/font.vlw' --provision '" +
+                      dir + "' >/dev/null 2>&1";
+    if (system(cmd.c_str()) != 0) {
+        fprintf(stderr, "[bench] build_pack.py --provision failed\n");
+        return false;
+    }
+    copyDir(dir + "/spiffs", device);
+    return writeFile(device + "/assets.part", readFile(dir + "/assets.part"));
+}
+
+// Drives packMgr::update() the way loop() does, timing every step; loopMs
+// is the modelled time between two loop() calls. cancelAfter > 0 cancels
+// that many steps into the emoji phase, after copying the device to
+// powerLossCopy if given (what a reboot at that moment would find).
+// resume continues the journalled install instead of starting `pack`.
+static DownloadRun driveDownload(const PackId& pack, uint32_t cancelAfter, uint32_t loopMs = 0,
+                                 bool resume = false, const std::string& powerLossCopy = "") {
+    DownloadRun r;
+    uint32_t emojiSteps = 0;
+    bool started = resume ? packMgr::resumeDownload()
+                          : packMgr::startDownload(pack.langIdx, pack.tierIdx);
+    if (!started) return r;
+
+    while (r.steps < MAX_STEPS) {
+        PackDownloadState s = packMgr::state();
+        if (s == PackDownloadState::Complete || s == PackDownloadState::Error ||
+            s == PackDownloadState::Cancelled) {
+            break;
+        }
+        if (cancelAfter && s == PackDownloadState::FetchingEmoji && ++emojiSteps > cancelAfter) {
+            if (!powerLossCopy.empty()) copyDir(SPIFFS.root(), powerLossCopy);
+            packMgr::cancelDownload();
+            continue;
+        }
+        if (loopMs) delay(loopMs);
+        auto t0 = std::chrono::steady_clock::now();
+        packMgr::update();
+        double us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - t0).count();
+        r.steps++;
+        r.totalUs += us;
+        r.maxStepUs = std::max(r.maxStepUs, us);
+    }
+    r.state = packMgr::state();
+    r.stats = packMgr::installStats();
+    char json[640];
+    if (packMgr::installStatsJson(json, sizeof(json)) < sizeof(json)) r.metrics = json;
+    packMgr::resetState();
+    return r;
+}
+
+// A pack asset as the renderer reads it, from the partition or a standalone file;
+// empty if the device doesn't hold it
+static std::string readAsset(const char* name) {
+    AssetReader in;
+    if (!in.open(name)) return "";
+    std::string data(in.size(), '\0');
+    size_t n = in.read((uint8_t*)&data[0], data.size());
+    in.close();
+    return n == data.size() ? data : "";
+}
+
+// Every file and asset on the device must be a complete copy of what the
+// server sent for `pack`, emoji kept from earlier packs included
+static bool deviceMatchesServer(const std::string& device, const std::string& server,
+                                const PackId& pack, size_t& files) {
+    std::string langDir = server + "/packs/" + pack.lang;
+    std::string tierDir = langDir + "/" + pack.tier;
+    files = 0;
+    for (const std::string& name : listDir(device)) {
+        std::string got = readFile(device + "/" + name);
+        std::string want;
+        if (name == "catalog.bin" || name == "assets.part") continue;  // Assets checked below
+        if (name == "inventory.idx" || name == "inventory.log" || name == "install.journal") {
+            want = got;  // The device's own
+        } else if (name == "manifest.json" || name == "vocab.pack" || name == "assets.idx") {
+            want = readFile(tierDir + "/" + name);
+        } else {
+            return false;  // Assets only live on the partition
+        }
+        if (got.empty() || got != want) return false;
+        files++;
+    }
+
+    std::vector<std::string> names = listDir(server + "/packs/emoji");
+    names.push_back("font.vlw");
+    for (const std::string& name : names) {
+        AssetLocation at;
+        if (!assetStore::locate(name.c_str(), at)) continue;
+        std::string want = name == "font.vlw" ? readFile(langDir + "/font.vlw")
+                                              : readFile(server + "/packs/emoji/" + name);
+        if (readAsset(name.c_str()) != want) return false;
+        files++;
+    }
+    return true;
+}
+
+// Every emoji the installed manifest.json uses is on the device
+static bool holdsPackEmoji(const std::string& device) {
+    std::string manifest = readFile(device + "/manifest.json");
+    const std::string key = "\"emoji\": \"";
+    if (manifest.find(key) == std::string::npos) return false;
+    for (size_t at = manifest.find(key); at != std::string::npos; at = manifest.find(key, at + 1)) {
+        size_t start = at + key.size();
+        std::string name = manifest.substr(start, manifest.find('"', start) - start) + ".bin";
+        AssetLocation held;
+        if (!assetStore::locate(name.c_str(), held)) return false;
+    }
+    return true;
+}
+
+// Files a device holding only `pack` has: its emoji, font, manifest.json,
+// vocab.pack, assets.idx and inventory.idx
+static size_t packFileCount(const std::string& server, const PackId& pack) {
+    std::string idx = readFile(server + "/packs/" + pack.lang + "/" + pack.tier + "/assets.idx");
+    return idx.size() < 8 ? 0 : ((uint8_t)idx[6] | ((uint8_t)idx[7] << 8)) + 4;
+}
+
+// Smallest assets partition whose storage budget still holds `pack`'s font
+// and emoji, leaving no room to spare for anything else
+static uint32_t tightPartition(const std::string& server, const PackId& pack) {
+    std::string idx = readFile(server + "/packs/" + pack.lang + "/" + pack.tier + "/assets.idx");
+    uint64_t bytes = 0;
+    for (size_t at = 8; at + sizeof(AssetRecord) <= idx.size(); at += sizeof(AssetRecord)) {
+        AssetRecord r;
+        memcpy(&r, idx.data() + at, sizeof(r));
+        bytes += r.size;
+    }
+    uint32_t size = (uint32_t)(bytes * 100 / 75);
+    return (size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+}
+
+// Server behaviour for one run (see host/HTTPClient.h); a cut bundle stops
+// half-way through its images
+static void setServer(const std::string& server, Bundle bundle, uint32_t keepAliveMax,
+                      bool silentClose, bool chunked) {
+    for (const PackId& pack : {SPANISH_BEGINNER, SPANISH_INTERMEDIATE, FRENCH_BEGINNER}) {
+        std::string path = server + "/packs/" + pack.lang + "/" + pack.tier + "/emoji.bundle";
+        std::string full = readFile(path + ".full");
+        unlink(path.c_str());
+        if (bundle == Bundle::Full) writeFile(path, full);
+        else if (bundle == Bundle::Cut) writeFile(path, full.substr(0, full.size() / 2));
+    }
+    HTTPClient::hostKeepAliveMax = keepAliveMax;
+    HTTPClient::hostSilentClose = silentClose;
+    HTTPClient::hostChunked = chunked;
+}
+
+// A device that still holds another pack, from firmware without an inventory
+static void resetDevice(const std::string& device) {
+    assetStore::release();  // A reboot: nothing of the old tables survives
+    for (const std::string& name : listDir(device)) unlink((device + "/" + name).c_str());
+    writeFile(device + "/stale.bin", "left over from the previous pack");
+}
+
+// Reads `names` READ_REPEATS times as the renderer does, each from its own
+// file under the SPIFFS root or mapped from the partition; `got` receives the first
+// pass. Returns the mean time per read.
+static double timeAssetReads(const std::vector<std::string>& names, bool perFile,
+                             std::vector<std::string>& got) {
+    std::vector<uint8_t> buf;
+    std::chrono::steady_clock::duration elapsed{};
+    for (int r = 0; r < READ_REPEATS; r++) {
+        for (const std::string& name : names) {
+            auto t0 = std::chrono::steady_clock::now();
+            size_t n = 0;
+            if (perFile) {
+                fs::File f = SPIFFS.open(("/" + name).c_str(), "r");
+                buf.resize(f ? f.size() : 0);
+                if (f) n = f.read(buf.data(), buf.size());
+                f.close();
+            } else {
+                AssetReader in;
+                buf.resize(in.open(name.c_str()) ? in.size() : 0);
+                n = in.read(buf.data(), buf.size());
+                in.close();
+            }
+            elapsed += std::chrono::steady_clock::now() - t0;
+            if (r == 0) got.push_back(std::string((const char*)buf.data(), n));
+        }
+    }
+    return std::chrono::duration<double, std::micro>(elapsed).count() / (READ_REPEATS * names.size());
+}
+
+// Every emoji the device holds, read from the assets partition and from the
+// file-per-asset layout it replaced (the device's files with each asset beside them
+// in perFile). Prints us/read, opens per read and the SPIFFS objects each
+// read's name lookups walk, which grows with every file in the partition.
+// Returns false if the two layouts read different bytes.
+static bool compareAssetReads(const std::string& device, const std::string& server,
+                              const std::string& perFile) {
+    std::vector<std::string> names;
+    for (const std::string& name : listDir(server + "/packs/emoji")) {
+        AssetLocation at;
+        if (assetStore::locate(name.c_str(), at)) names.push_back(name);  // Index built untimed
+    }
+    mkdir(perFile.c_str(), 0755);
+    copyDir(device, perFile);
+    unlink((perFile + "/assets.part").c_str());
+    for (const std::string& name : names) writeFile(perFile + "/" + name, readAsset(name.c_str()));
+
+    printf("\n%-16s %7s %7s %9s %10s %9s %5s\n", "asset reads", "files", "reads", "us/read",
+           "opens/read", "scanned", "same");
+    std::vector<std::string> fromFiles, fromPartition;
+    struct {
+        const char* name;
+        std::string root;
+        bool perFile;
+        std::vector<std::string>& got;
+    } layouts[] = {
+        {"file_per_asset", perFile, true, fromFiles},
+        {"partition", device, false, fromPartition},
+    };
+    for (const auto& l : layouts) {
+        SPIFFS.setRoot(l.root.c_str());
+        size_t files = listDir(l.root).size();
+        uint32_t opens = fs::FS::hostOpens;
+        double us = timeAssetReads(names, l.perFile, l.got);
+        double perRead = (double)(fs::FS::hostOpens - opens) / (READ_REPEATS * names.size());
+        printf("%-16s %7u %7u %9.2f %10.2f %9.1f %5s\n", l.name, (unsigned)files,
+               (unsigned)names.size(), us, perRead, perRead * files,
+               l.got == fromFiles ? "yes" : "NO");
+    }
+    SPIFFS.setRoot(device.c_str());
+    return !fromPartition.empty() && fromPartition == fromFiles;
+}
+
+// Per-phase and per-file metrics must add up to the install totals, and
+// the JSON record must fit the buffer endInstall() logs it from
+static bool metricsConsistent(const DownloadRun& r) {
+    const PackInstallStats& st = r.stats;
+    uint32_t bytes = 0, files = 0, latencyFiles = 0;
+    for (uint8_t i = (uint8_t)PackPhase::Manifest; i < (uint8_t)PackPhase::Count; i++) {
+        bytes += st.phase[i].bytes;
+        files += st.phase[i].files;
+    }
+    for (uint16_t n : st.latency) latencyFiles += n;
+    return bytes == st.bytes && files == latencyFiles && files <= st.requests &&
+           st.phase[(uint8_t)PackPhase::Catalog].files == 1 && st.minMaxAlloc <= st.minFreeHeap &&
+           !r.metrics.empty();
+}
+
+// wantFiles > 0: the device must hold exactly that many files afterwards
+static bool report(const char* name, const DownloadRun& r, PackDownloadState want, bool filesOk,
+                   size_t files, size_t wantFiles) {
+    bool ok = r.state == want && filesOk && (wantFiles == 0 || files == wantFiles) &&
+              metricsConsistent(r);
+    printf("%-16s %7u %9.1f %9.1f %8u %10u %9u %9u %6u %5s\n", name, r.steps,
+           r.steps ? r.totalUs / r.steps : 0.0, r.maxStepUs, r.stats.requests,
+           r.stats.handshakes, r.stats.bytes, r.stats.ms, (unsigned)files, ok ? "yes" : "NO");
+    return ok;
+}
+
+// Catalog with more languages than the old fixed tables held, each with
+// fields and descriptions the device doesn't keep
+static std::string largeCatalog() {
+    std::string json = "{\"version\":3,\"languages\":[";
+    char buf[256];
+    for (uint8_t li = 0; li < LARGE_CATALOG_LANGUAGES; li++) {
+        snprintf(buf, sizeof(buf), "%s{\"id\":\"lang%u\",\"name\":\"Language %u\",\"flag\":\"l%u\","
+                 "\"description\":\"%s\",\"tiers\":[", li ? "," : "", li, li, li % 10,
+                 std::string(120, 'd').c_str());
+        json += buf;
+        for (uint8_t ti = 0; ti < LARGE_CATALOG_TIERS; ti++) {
+            snprintf(buf, sizeof(buf), "%s{\"id\":\"tier%u\",\"name\":\"Tier %u\",\"words\":%u,"
+                     "\"version\":%u,\"manifestSize\":%u,\"fontSize\":%u,\"tags\":[\"a\",\"b\"]}",
+                     ti ? "," : "", ti, ti, 100 + li, ti + 1, 10000 + li * 10 + ti, 20000 + li);
+            json += buf;
+        }
+        json += "]}";
+    }
+    return json + "]}";
+}
+
+// A catalog of `languages` as the server wrote it (see largeCatalog())
+static bool holdsLargeCatalog() {
+    if (packMgr::languageCount() != LARGE_CATALOG_LANGUAGES) return false;
+    uint8_t last = LARGE_CATALOG_LANGUAGES - 1;
+    const CatalogTier& t = packMgr::tier(last, LARGE_CATALOG_TIERS - 1);
+    return strcmp(packMgr::language(last).id, "lang47") == 0 &&
+           packMgr::tierCount(last) == LARGE_CATALOG_TIERS && strcmp(t.id, "tier4") == 0 &&
+           t.words == 100 + last && t.manifestSize == 10000u + last * 10 + 4;
+}
+
+// update() calls a catalog fetch takes, each one piece of it. lastPeak
+// gets the most heap the last call needed: after a 200 that is the parse of
+// the buffered body alone, without the stand-in server's buffers.
+static uint32_t refreshSteps(size_t* lastPeak = nullptr) {
+    uint32_t steps = 0;
+    do {
+        hostHeap::resetPeak();
+        packMgr::update();
+        if (lastPeak) *lastPeak = hostHeap::peakSince();
+        steps++;
+    } while (packMgr::fetchingCatalog());
+    return steps;
+}
+
+// fetchCatalog() carried through; true if it left the catalog loaded
+static bool fetchCatalog(size_t* parsePeak = nullptr) {
+    if (!packMgr::fetchCatalog()) return false;
+    refreshSteps(parsePeak);
+    return packMgr::state() == PackDownloadState::Idle;
+}
+
+// Heap the parse took before the catalog was filtered and buffered on
+// SPIFFS: the whole body in a String, then a document of all of it
+static size_t wholeBodyParsePeak(const std::string& body) {
+    hostHeap::resetPeak();
+    {
+        String payload(body.c_str());
+        JsonDocument doc;
+        deserializeJson(doc, payload.c_str());
+    }
+    return hostHeap::peakSince();
+}
+
+// The catalog the browser opens on: cached on the device by a catalog fetch,
+// loaded back without a request, refreshed with a 304 while unchanged and
+// replaced once the server's copy changes. Then a catalog larger than the
+// old fixed tables, chunked, buffered on SPIFFS and parsed from there.
+static bool checkCatalog(const std::string& server) {
+    uint32_t requests = HTTPClient::hostRequests, connects = HTTPClient::hostConnects;
+    uint32_t notModified = HTTPClient::hostNotModified;
+    uint8_t revision = packMgr::catalogRevision();
+    bool cached = packMgr::loadCachedCatalog() && packMgr::languageCount() == 2 &&
+                  packMgr::tierCount(0) == 2 &&
+                  strcmp(packMgr::tier(0, 1).id, SPANISH_INTERMEDIATE.tier) == 0 &&
+                  HTTPClient::hostRequests == requests;
+
+    packMgr::refreshCatalog();
+    uint32_t steps = refreshSteps();
+    bool unchanged = HTTPClient::hostNotModified == notModified + 1 &&
+                     packMgr::catalogRevision() == (uint8_t)(revision + 1);
+
+    std::string path = server + "/catalog.json";
+    writeFile(path, readFile(path) + "\n");
+    packMgr::refreshCatalog();
+    steps += refreshSteps();
+    bool changed = HTTPClient::hostNotModified == notModified + 1 &&
+                   packMgr::catalogRevision() == (uint8_t)(revision + 2) &&
+                   packMgr::languageCount() == 2;
+
+    printf("catalog: cache %s, refresh %s, changed %s (%u requests, %u handshakes, %u steps)\n",
+           cached ? "ok" : "NO", unchanged ? "304" : "NO", changed ? "reloaded" : "NO",
+           HTTPClient::hostRequests - requests, HTTPClient::hostConnects - connects, steps);
+
+    std::string original = readFile(path);
+    std::string large = largeCatalog();
+    writeFile(path, large);
+    HTTPClient::hostChunked = true;
+    size_t peak = 0;
+    bool fetched = fetchCatalog(&peak);
+    HTTPClient::hostChunked = false;
+    bool big = fetched && holdsLargeCatalog() && packMgr::loadCachedCatalog() && holdsLargeCatalog();
+    printf("catalog: %u languages, %u B chunked, parse peak heap %u B (whole body and document: %u B): %s\n",
+           packMgr::languageCount(), (unsigned)large.size(), (unsigned)peak,
+           (unsigned)wholeBodyParsePeak(large), big ? "ok" : "NO");
+
+    writeFile(path, original);
+    bool restored = fetchCatalog() && packMgr::languageCount() == 2;
+    return cached && unchanged && changed && big && restored;
+}
+
+namespace bench {
+
+bool runDownload(const char* buildPack) {
+    char tmp[] = "/tmp/osmosis-download-XXXXXX";
+    if (!mkdtemp(tmp)) return false;
+    std::string server = std::string(tmp) + "/server";
+    std::string device = std::string(tmp) + "/device";
+    mkdir(server.c_str(), 0755);
+    mkdir(device.c_str(), 0755);
+    std::string spiffsRoot = SPIFFS.root();
+    OsmosisSettings savedSettings = settingsMgr.settings();
+
+    bool ok = buildServer(spiffsRoot, server, buildPack);
+    HTTPClient::hostMount(BASE_URL, server.c_str());
+    hostNet::setWifiConnected(true);
+    SPIFFS.setRoot(device.c_str());
+    ok = ok && fetchCatalog() && checkCatalog(server);
+
+    printf("\n%-16s %7s %9s %9s %8s %10s %9s %9s %6s %5s\n", "download", "steps", "us/step",
+           "max us", "requests", "handshakes", "bytes", "model ms", "files", "ok");
+    HTTPClient::hostHandshakeMs = HANDSHAKE_MS;
+    HTTPClient::hostRequestMs = REQUEST_MS;
+
+    size_t files = 0;
+    std::string metrics;  // Of the plain bundled install
+    uint32_t fullBytes = 0;
+    size_t fullFiles = packFileCount(server, SPANISH_BEGINNER);
+    bool filesOk;
+    if (ok) {
+        // Full installs over a device holding another pack: a new connection
+        // and request per file (before keep-alive and bundles), one kept-alive
+        // connection, then the emoji bundle plain, chunked, over a server that
+        // drops the connection every other response without notice, and cut
+        // short so the remaining emoji come one by one
+        struct {
+            const char* name;
+            Bundle bundle;
+            uint32_t keepAliveMax;
+            bool silent;
+            bool chunked;
+        } installs[] = {
+            {"per_file_conn", Bundle::None, 1, false, false},
+            {"no_bundle", Bundle::None, 0, false, false},
+            {"install", Bundle::Full, 0, false, false},
+            {"install_chunked", Bundle::Full, 0, false, true},
+            {"install_drops", Bundle::Full, 2, true, false},
+            {"bundle_cut", Bundle::Cut, 0, false, false},
+        };
+        for (const auto& in : installs) {
+            resetDevice(device);
+            setServer(server, in.bundle, in.keepAliveMax, in.silent, in.chunked);
+            DownloadRun run = driveDownload(SPANISH_BEGINNER, 0);
+            filesOk = deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                      holdsPackEmoji(device) && !exists(device + "/stale.bin");
+            ok = report(in.name, run, PackDownloadState::Complete, filesOk, files, fullFiles) && ok;
+            if (in.bundle == Bundle::Full && in.keepAliveMax == 0 && !in.chunked) {
+                metrics = run.metrics;
+                fullBytes = run.stats.bytes;
+            }
+        }
+        setServer(server, Bundle::Full, 0, false, false);
+
+        // Every 3rd response cut off: each failed file is fetched again after
+        // a backoff, the cut bundle's remainder one by one
+        resetDevice(device);
+        HTTPClient::hostCutEvery = CUT_EVERY;
+        DownloadRun flaky = driveDownload(SPANISH_BEGINNER, 0, LOOP_MS);
+        HTTPClient::hostCutEvery = 0;
+        filesOk = deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  holdsPackEmoji(device) && flaky.stats.retries > 0;
+        ok = report("flaky_network", flaky, PackDownloadState::Complete, filesOk, files, fullFiles) && ok;
+
+        // Bit errors in the bundle and every other emoji file after it: each
+        // damaged image fails its assets.idx hash and is fetched again, none
+        // is kept
+        resetDevice(device);
+        uint32_t corrupted = HTTPClient::hostCorrupted;
+        HTTPClient::hostCorruptEvery = CORRUPT_EVERY;
+        HTTPClient::hostCorruptMatch = "emoji";
+        DownloadRun corrupt = driveDownload(SPANISH_BEGINNER, 0, LOOP_MS);
+        HTTPClient::hostCorruptEvery = 0;
+        corrupted = HTTPClient::hostCorrupted - corrupted;
+        filesOk = deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  holdsPackEmoji(device) && corrupted > 1 && corrupt.stats.rejected > corrupted &&
+                  corrupt.stats.retries > 0;
+        ok = report("corrupt", corrupt, PackDownloadState::Complete, filesOk, files, fullFiles) && ok;
+
+        // Power lost mid-bundle: the device boots with the journal, doesn't
+        // take the partial pack for installed, and resumes without fetching
+        // the images it already holds again
+        resetDevice(device);
+        std::string rebooted = std::string(tmp) + "/rebooted";
+        mkdir(rebooted.c_str(), 0755);
+        driveDownload(SPANISH_BEGINNER, POWER_LOSS_AFTER_EMOJI_STEPS, 0, false, rebooted);
+        copyDir(rebooted, device);
+        assetStore::release();
+        bool pending = !packMgr::hasInstalledPack() && packMgr::hasPendingInstall();
+        DownloadRun resumed = driveDownload(SPANISH_BEGINNER, 0, 0, true);
+        filesOk = pending && deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  holdsPackEmoji(device) && packMgr::hasInstalledPack() &&
+                  !exists(device + "/install.journal") && resumed.stats.bytes < fullBytes;
+        ok = report("power_loss", resumed, PackDownloadState::Complete, filesOk, files, fullFiles) && ok;
+
+        // Updates over the last install: only what the device doesn't hold
+        // yet is fetched, files no pack uses stay while storage allows
+        uint32_t assetsSize = hostPartitionTableSize("assets");
+        struct {
+            const char* name;
+            const PackId& pack;
+            uint32_t partitionBytes;  // Assets partition size
+            size_t wantFiles;
+        } updates[] = {
+            {"reinstall", SPANISH_BEGINNER, assetsSize, fullFiles},
+            {"tier_switch", SPANISH_INTERMEDIATE, assetsSize, fullFiles},
+            {"lang_switch", FRENCH_BEGINNER, assetsSize, fullFiles},
+            {"tight_storage", SPANISH_INTERMEDIATE, tightPartition(server, SPANISH_INTERMEDIATE),
+             packFileCount(server, SPANISH_INTERMEDIATE)},
+            {"tier_back", SPANISH_BEGINNER, assetsSize, fullFiles},
+        };
+        for (const auto& up : updates) {
+            hostSetPartitionSize("assets", up.partitionBytes);
+            DownloadRun run = driveDownload(up.pack, 0);
+            hostSetPartitionSize("assets", assetsSize);
+            filesOk = deviceMatchesServer(device, server, up.pack, files) && holdsPackEmoji(device);
+            ok = report(up.name, run, PackDownloadState::Complete, filesOk, files, up.wantFiles) && ok;
+        }
+        std::string updated = std::string(tmp) + "/updated";  // For compareAssetReads()
+        mkdir(updated.c_str(), 0755);
+        copyDir(device, updated);
+
+        // Flashed over USB instead of downloaded: the pack reads straight
+        // away, and installing it over Wi-Fi fetches no font or emoji
+        assetStore::release();
+        bool provisioned = provisionDevice(spiffsRoot, device, std::string(tmp) + "/provision",
+                                           buildPack);
+        AssetLocation provisionedFont;
+        provisioned = provisioned && packMgr::hasInstalledPack() && holdsPackEmoji(device) &&
+                      assetStore::locate("font.vlw", provisionedFont);
+        DownloadRun overProvisioned = driveDownload(SPANISH_BEGINNER, 0);
+        filesOk = provisioned && deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  holdsPackEmoji(device) &&
+                  overProvisioned.stats.phase[(uint8_t)PackPhase::Font].bytes == 0 &&
+                  overProvisioned.stats.phase[(uint8_t)PackPhase::Emoji].bytes == 0;
+        ok = report("provisioned", overProvisioned, PackDownloadState::Complete, filesOk, files,
+                    fullFiles) && ok;
+
+        // Update cancelled before it overwrote anything: the pack installed
+        // before stays installed, manifest and all
+        DownloadRun cancelledUpdate;
+        if (packMgr::startDownload(SPANISH_INTERMEDIATE.langIdx, SPANISH_INTERMEDIATE.tierIdx)) {
+            packMgr::cancelDownload();
+            cancelledUpdate.state = packMgr::state();
+            cancelledUpdate.stats = packMgr::installStats();
+            char json[640];
+            if (packMgr::installStatsJson(json, sizeof(json)) < sizeof(json)) {
+                cancelledUpdate.metrics = json;
+            }
+            packMgr::resetState();
+        }
+        filesOk = packMgr::hasInstalledPack() &&
+                  deviceMatchesServer(device, server, SPANISH_BEGINNER, files);
+        ok = report("cancel_update", cancelledUpdate, PackDownloadState::Cancelled, filesOk, files,
+                    fullFiles) && ok;
+
+        // Cancel mid-bundle: no manifest, no partial image left behind
+        resetDevice(device);
+        DownloadRun cancelled = driveDownload(SPANISH_BEGINNER, CANCEL_AFTER_EMOJI_STEPS);
+        filesOk = deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  !exists(device + "/manifest.json") && !exists(device + "/vocab.pack");
+        ok = report("cancel", cancelled, PackDownloadState::Cancelled, filesOk, files, 0) && ok;
+
+        // Missing font: the install fails and leaves no partial font behind
+        resetDevice(device);
+        unlink((server + "/packs/spanish/font.vlw").c_str());
+        DownloadRun failed = driveDownload(SPANISH_BEGINNER, 0);
+        AssetLocation font;
+        filesOk = deviceMatchesServer(device, server, SPANISH_BEGINNER, files) &&
+                  !assetStore::locate("font.vlw", font) && !exists(device + "/font.vlw");
+        ok = report("missing_font", failed, PackDownloadState::Error, filesOk, files, 0) && ok;
+        printf("install metrics: %s\n", metrics.c_str());
+
+        assetStore::release();
+        SPIFFS.setRoot(updated.c_str());
+        ok = compareAssetReads(updated, server, std::string(tmp) + "/per_file") && ok;
+        assetStore::release();
+    }
+
+    HTTPClient::hostHandshakeMs = 0;
+    HTTPClient::hostRequestMs = 0;
+    SPIFFS.setRoot(spiffsRoot.c_str());
+    hostNet::setWifiConnected(false);
+    HTTPClient::hostUnmountAll();
+    settingsMgr.settings() = savedSettings;
+    removeTree(tmp);
+    return ok;
+}
+
+}  // namespace bench
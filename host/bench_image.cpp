@@ -0,0 +1,662 @@
+#include "bench.h"
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include "asset_store.h"
+#include "display_manager.h"
+#include "host_heap.h"
+#include "image_renderer.h"
+
+static std::vector<uint8_t> readAll(const char* path) {
+    fs::File f = SPIFFS.open(path, "r");
+    std::vector<uint8_t> data(f ? f.size() : 0);
+    if (f) data.resize(f.read(data.data(), data.size()));
+    return data;
+}
+
+// Reference decode: the original whole-file ORLE decoder, kept here so the
+// renderer can be checked against it as it changes.
+static bool referenceDecode(const std::vector<uint8_t>& data, std::vector<uint16_t>& out) {
+    size_t n = data.size();
+    if (n < 12 || memcmp(data.data(), "ORLE", 4) != 0) return false;
+
+    uint16_t w = (data[4] << 8) | data[5];
+    uint16_t h = (data[6] << 8) | data[7];
+    uint32_t size = ((uint32_t)data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11];
+    if (w != IMG_W || h != IMG_H || 12 + size > n) return false;
+
+    out.assign(IMG_W * IMG_H, 0);
+    const uint8_t* src = data.data() + 12;
+    uint32_t pos = 0, dst = 0;
+    while (pos < size && dst < out.size()) {
+        uint8_t hdr = src[pos++];
+        uint16_t count = (hdr & 0x7F) + 1;
+        if (hdr & 0x80) {
+            if (pos + 2 > size) return false;
+            uint16_t px = (src[pos] << 8) | src[pos + 1];
+            pos += 2;
+            for (uint16_t i = 0; i < count && dst < out.size(); i++) out[dst++] = px;
+        } else {
+            if (pos + count * 2u > size) return false;
+            for (uint16_t i = 0; i < count && dst < out.size(); i++, pos += 2) {
+                out[dst++] = (src[pos] << 8) | src[pos + 1];
+            }
+        }
+    }
+    return true;
+}
+
+// Reference decode of the row-coded formats, written from their
+// description in tools/convert_emoji.py: ORL2, or ORLP with a palette.
+// Row offsets must tile the payload from 0, each row coding exactly IMG_W
+// pixels in records that stay within it.
+static bool referenceDecodeRows(const std::vector<uint8_t>& data, std::vector<uint16_t>& out) {
+    auto u16 = [&](size_t at) { return (uint32_t)(data[at] << 8) | data[at + 1]; };
+    if (data.size() < 14) return false;
+    bool paletted = memcmp(data.data(), "ORLP", 4) == 0;
+    if (!paletted && memcmp(data.data(), "ORL2", 4) != 0) return false;
+    uint32_t size = (u16(8) << 16) | u16(10);
+    size_t paletteAt = 14, paletteSize = paletted ? u16(12) : 0;
+    size_t tableAt = paletted ? paletteAt + paletteSize * 2 : 12;
+    size_t payloadAt = tableAt + IMG_H * 2;
+    if (u16(4) != IMG_W || u16(6) != IMG_H || paletteSize > 256 || data.size() < payloadAt ||
+        size > data.size() - payloadAt) {
+        return false;
+    }
+
+    out.assign(IMG_W * IMG_H, 0);
+    const uint8_t* src = data.data() + payloadAt;
+    uint32_t pos = 0;
+    for (int r = 0; r < IMG_H; r++) {
+        uint32_t start = u16(tableAt + r * 2);
+        uint32_t end = (r + 1 < IMG_H) ? u16(tableAt + r * 2 + 2) : size;
+        if (start != pos || end < start || end > size) return false;
+        int x = 0;
+        while (pos < end) {
+            uint8_t hdr = src[pos++];
+            bool indexed = paletted && !(hdr & 0x80);
+            bool run = hdr & (paletted ? 0x40 : 0x80);
+            int count = (hdr & (paletted ? 0x3F : 0x7F)) + 1;
+            uint32_t width = indexed ? 1 : 2;
+            uint32_t bytes = (run ? 1 : count) * width;
+            if (x + count > IMG_W || pos + bytes > end) return false;
+            for (int i = 0; i < count; i++, x++) {
+                uint32_t at = pos + (run ? 0 : i * width);
+                if (indexed && src[at] >= paletteSize) return false;
+                out[r * IMG_W + x] = indexed ? u16(paletteAt + src[at] * 2) : (src[at] << 8) | src[at + 1];
+            }
+            pos += bytes;
+        }
+        if (x != IMG_W) return false;
+    }
+    return true;
+}
+
+// rle_compress() of tools/convert_emoji.py
+static void encodeRle(const uint16_t* px, int n, std::vector<uint8_t>& out) {
+    auto put = [&](uint16_t v) { out.push_back(v >> 8); out.push_back(v & 0xFF); };
+    int i = 0;
+    while (i < n) {
+        int runStart = i;
+        while (i < n - 1 && px[i] == px[i + 1] && i - runStart < 127) i++;
+        int runLen = i - runStart + 1;
+        if (runLen >= 3) {
+            out.push_back(0x80 | (runLen - 1));
+            put(px[runStart]);
+            i++;
+            continue;
+        }
+        i = runStart;
+        while (i < n && i - runStart < 127) {
+            if (i < n - 2 && px[i] == px[i + 1] && px[i + 1] == px[i + 2]) break;
+            i++;
+        }
+        out.push_back(i - runStart - 1);
+        for (int j = runStart; j < i; j++) put(px[j]);
+    }
+}
+
+// palette_compress() of tools/convert_emoji.py; index is -1 for colours
+// not in the palette
+static void encodePaletteRle(const uint16_t* px, int n, const std::vector<int>& index,
+                             std::vector<uint8_t>& out) {
+    auto put = [&](int from, int count, bool run) {
+        bool indexed = index[px[from]] >= 0;
+        out.push_back((indexed ? 0 : 0x80) | (run ? 0x40 : 0) | (count - 1));
+        for (int j = from; j < from + (run ? 1 : count); j++) {
+            if (indexed) {
+                out.push_back(index[px[j]]);
+            } else {
+                out.push_back(px[j] >> 8);
+                out.push_back(px[j] & 0xFF);
+            }
+        }
+    };
+    int i = 0;
+    while (i < n) {
+        int runLen = 1;
+        while (i + runLen < n && px[i + runLen] == px[i] && runLen < 64) runLen++;
+        if (runLen >= 3) {
+            put(i, runLen, true);
+            i += runLen;
+            continue;
+        }
+        bool indexed = index[px[i]] >= 0;
+        int start = i;
+        while (i < n && i - start < 64 && (index[px[i]] >= 0) == indexed) {
+            if (i < n - 2 && px[i] == px[i + 1] && px[i + 1] == px[i + 2]) break;
+            i++;
+        }
+        put(start, i - start, false);
+    }
+}
+
+static void putSize(std::vector<uint8_t>& d, uint32_t size) {
+    d[8] = size >> 24; d[9] = size >> 16; d[10] = size >> 8; d[11] = size;
+}
+
+// encode_v1() of tools/convert_emoji.py
+static std::vector<uint8_t> encodeV1(const std::vector<uint16_t>& img) {
+    std::vector<uint8_t> d = {'O', 'R', 'L', 'E', 0, IMG_W, 0, IMG_H, 0, 0, 0, 0};
+    encodeRle(img.data(), IMG_W * IMG_H, d);
+    putSize(d, d.size() - 12);
+    return d;
+}
+
+// encode_v2() of tools/convert_emoji.py
+static std::vector<uint8_t> encodeV2(const std::vector<uint16_t>& img) {
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> d = {'O', 'R', 'L', '2', 0, IMG_W, 0, IMG_H, 0, 0, 0, 0};
+    for (int r = 0; r < IMG_H; r++) {
+        d.push_back(payload.size() >> 8);
+        d.push_back(payload.size() & 0xFF);
+        encodeRle(&img[r * IMG_W], IMG_W, payload);
+    }
+    putSize(d, payload.size());
+    d.insert(d.end(), payload.begin(), payload.end());
+    return d;
+}
+
+// encode_palette() of tools/convert_emoji.py
+static std::vector<uint8_t> encodePalette(const std::vector<uint16_t>& img) {
+    std::map<uint16_t, int> counts;
+    for (uint16_t px : img) counts[px]++;
+    std::vector<uint16_t> palette;
+    for (const auto& c : counts) {
+        if (c.second > 1) palette.push_back(c.first);
+    }
+    std::sort(palette.begin(), palette.end(), [&](uint16_t a, uint16_t b) {
+        return counts[a] != counts[b] ? counts[a] > counts[b] : a < b;
+    });
+    if (palette.size() > 256) palette.resize(256);
+    std::vector<int> index(65536, -1);
+    for (size_t i = 0; i < palette.size(); i++) index[palette[i]] = i;
+
+    std::vector<uint8_t> d = {'O', 'R', 'L', 'P', 0, IMG_W, 0, IMG_H, 0, 0, 0, 0};
+    d.push_back(palette.size() >> 8);
+    d.push_back(palette.size() & 0xFF);
+    for (uint16_t c : palette) {
+        d.push_back(c >> 8);
+        d.push_back(c & 0xFF);
+    }
+    std::vector<uint8_t> payload;
+    for (int r = 0; r < IMG_H; r++) {
+        d.push_back(payload.size() >> 8);
+        d.push_back(payload.size() & 0xFF);
+        encodePaletteRle(&img[r * IMG_W], IMG_W, index, payload);
+    }
+    putSize(d, payload.size());
+    d.insert(d.end(), payload.begin(), payload.end());
+    return d;
+}
+
+// Reference decode of whichever format data's magic names
+static bool referenceDecodeAny(const std::vector<uint8_t>& data, std::vector<uint16_t>& out) {
+    if (data.size() >= 4 && memcmp(data.data(), "ORLE", 4) == 0) return referenceDecode(data, out);
+    return referenceDecodeRows(data, out);
+}
+
+// The formats convert_emoji.py writes
+struct Format {
+    const char* label;
+    std::vector<uint8_t> (*encode)(const std::vector<uint16_t>& img);
+};
+static const Format FORMATS[] = {
+    {"v1", encodeV1},
+    {"v2", encodeV2},
+    {"pal", encodePalette},
+};
+
+// Reference draw: the original per-pixel nearest-neighbour loop
+static void referenceDraw(TFT_eSprite& strip, const std::vector<uint16_t>& img,
+                          int x, int y, int stripY) {
+    int dispRowStart = stripY - y;
+    int dispRowEnd = dispRowStart + STRIP_H;
+    if (dispRowStart < 0) dispRowStart = 0;
+    if (dispRowEnd > IMG_DISPLAY_H) dispRowEnd = IMG_DISPLAY_H;
+
+    for (int dispRow = dispRowStart; dispRow < dispRowEnd; dispRow++) {
+        int spriteRow = y + dispRow - stripY;
+        int imgRow = dispRow * IMG_H / IMG_DISPLAY_H;
+        const uint16_t* srcRow = &img[imgRow * IMG_W];
+        for (int dispCol = 0; dispCol < IMG_DISPLAY_W; dispCol++) {
+            uint16_t pixel = srcRow[dispCol * IMG_W / IMG_DISPLAY_W];
+            if (pixel != 0x0000) strip.drawPixel(x + dispCol, spriteRow, pixel);
+        }
+    }
+}
+
+static std::vector<std::string> listEmoji() {
+    std::vector<std::string> names;
+    fs::File root = SPIFFS.open("/");
+    for (fs::File f = root.openNextFile(); f; f = root.openNextFile()) {
+        std::string name = f.name() + 1;  // drop leading '/'
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+            names.push_back(name.substr(0, name.size() - 4));
+        }
+    }
+    return names;
+}
+
+static const uint16_t BENCH_BG = 0x0861;  // Non-zero so transparency mistakes show up
+static const int FIRST_STRIP = IMG_Y / STRIP_H;
+static const int LAST_STRIP = (IMG_Y + IMG_DISPLAY_H - 1) / STRIP_H;
+
+// Draws strip s of the preloaded image and of img; true if they match
+static bool stripMatches(TFT_eSprite& ref, const std::vector<uint16_t>& img, int s) {
+    TFT_eSprite& cur = display.getStrip();
+    int stripY = s * STRIP_H;
+    ref.fillSprite(BENCH_BG);
+    cur.fillSprite(BENCH_BG);
+    referenceDraw(ref, img, IMG_X, IMG_Y, stripY);
+    imageRenderer::drawPreloaded(IMG_X, IMG_Y, stripY);
+    return memcmp(ref.getPointer(), cur.getPointer(), SCREEN_W * STRIP_H * 2) == 0;
+}
+
+// One corrupted variant of an ORLE file: flipped payload bytes, a
+// truncation, a wrong size field, random record headers or a damaged
+// header, palette or row table
+static std::vector<uint8_t> mutate(const std::vector<uint8_t>& src, std::mt19937& rng) {
+    std::vector<uint8_t> d = src;
+    auto pick = [&](size_t n) { return (size_t)(rng() % n); };
+    switch (rng() % 5) {
+    case 0:
+        for (int i = 0, n = 1 + pick(8); i < n && d.size() > 12; i++) {
+            d[12 + pick(d.size() - 12)] ^= (uint8_t)(1 + pick(255));
+        }
+        break;
+    case 1:
+        d.resize(pick(d.size() + 1));
+        break;
+    case 2:
+        if (d.size() >= 12) {
+            uint32_t size = (uint32_t)(d.size() - 12) + (int32_t)pick(64) - 32;
+            d[8] = size >> 24; d[9] = size >> 16; d[10] = size >> 8; d[11] = size;
+        }
+        break;
+    case 3:
+        for (int i = 0, n = 1 + pick(4); i < n && d.size() > 12; i++) {
+            d[12 + pick(d.size() - 12)] = (uint8_t)(rng() & 0x80 ? 0x80 | pick(128) : pick(128));
+        }
+        break;
+    default:
+        const size_t head = 12 + 2 + IMG_H * 2;  // Up to the end of a v2 row table
+        for (int i = 0, n = 1 + pick(2); i < n && !d.empty(); i++) {
+            d[pick(d.size() < head ? d.size() : head)] ^= (uint8_t)(1 + pick(255));
+        }
+        break;
+    }
+    return d;
+}
+
+// Writes data to the assets partition of the SPIFFS root as `name`
+static bool storeAsset(const char* name, const std::vector<uint8_t>& data) {
+    if (!assetStore::beginWrite(name, data.size())) return false;
+    if (!data.empty() && !assetStore::write(data.data(), data.size())) {
+        assetStore::abortWrite();
+        return false;
+    }
+    assetStore::commitWrite();
+    return true;
+}
+
+// Makes the empty directory dir the SPIFFS root, with an empty inventory and
+// an install under way so files can go to its assets partition
+static bool useScratchRoot(const char* dir) {
+    assetStore::release();
+    SPIFFS.setRoot(dir);
+    assetStore::beginInstall();
+    return assetStore::save();
+}
+
+// Back to root, removing the scratch directory and everything in it
+static void dropScratchRoot(const char* dir, const std::string& root) {
+    assetStore::release();
+    imageRenderer::invalidateCache();
+    SPIFFS.setRoot(root.c_str());
+    if (DIR* d = opendir(dir)) {
+        while (dirent* e = readdir(d)) {
+            if (e->d_name[0] != '.') unlink((std::string(dir) + "/" + e->d_name).c_str());
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return;
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+// One row of the fuzz table
+struct FuzzTally {
+    std::string label;
+    uint32_t refOk = 0, curOk = 0, mismatches = 0;
+};
+
+// Preloads stem and checks it against the reference outcome: accepted
+// exactly when the reference accepts it, with the same pixels
+static void fuzzCheck(FuzzTally& t, TFT_eSprite& ref, const char* stem, bool refDecoded,
+                      const std::vector<uint16_t>& img, int i) {
+    imageRenderer::invalidateCache();
+    bool curDecoded = imageRenderer::preloadImage(stem);
+    t.refOk += refDecoded;
+    t.curOk += curDecoded;
+
+    bool same = curDecoded == refDecoded;
+    if (same && refDecoded) {
+        for (int s = FIRST_STRIP; same && s <= LAST_STRIP; s++) same = stripMatches(ref, img, s);
+    }
+    if (!same && t.mismatches++ < 5) {
+        fprintf(stderr, "[bench] %s case %d differs from reference\n", t.label.c_str(), i);
+    }
+}
+
+// Every emoji in the SPIFFS root the reference can decode, with its pixels
+static void loadCorpus(std::vector<std::string>& names, std::vector<std::vector<uint16_t>>& images,
+                       bool report) {
+    for (const std::string& name : listEmoji()) {
+        std::vector<uint16_t> img;
+        if (!referenceDecodeAny(readAll(("/" + name + ".bin").c_str()), img)) {
+            if (report) fprintf(stderr, "[bench] Skipping %s (decode failed)\n", name.c_str());
+            continue;
+        }
+        names.push_back(name);
+        images.push_back(img);
+    }
+}
+
+// Preloads every name `rounds` times from a cold cache; microseconds per load
+static double timeLoads(const std::vector<std::string>& names, int rounds, uint32_t& failures) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const std::string& name : names) {
+            imageRenderer::invalidateCache();
+            if (!imageRenderer::preloadImage(name.c_str()) && r == 0) failures++;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / (rounds * names.size());
+}
+
+// Preloads every name from a cold cache, prefetched first if asked, and
+// compares each strip it draws with its reference pixels; the number that
+// fail to load or differ
+static uint32_t checkLoads(TFT_eSprite& ref, const std::vector<std::string>& names,
+                           const std::vector<std::vector<uint16_t>>& images, const char* label,
+                           bool prefetched = false) {
+    uint32_t bad = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        imageRenderer::invalidateCache();
+        bool same = !prefetched || imageRenderer::prefetch(names[i].c_str());
+        same = same && imageRenderer::preloadImage(names[i].c_str());
+        for (int s = FIRST_STRIP; same && s <= LAST_STRIP; s++) same = stripMatches(ref, images[i], s);
+        if (!same && bad++ < 5) {
+            fprintf(stderr, "[bench] %s: %s differs from reference\n", label, names[i].c_str());
+        }
+    }
+    return bad;
+}
+
+namespace bench {
+
+bool fuzzDecoder(int cases) {
+    std::vector<std::string> names;
+    std::vector<std::vector<uint16_t>> images;
+    loadCorpus(names, images, false);
+    if (names.empty()) return false;
+
+    // Each format's encoding of every emoji, and a standalone file and a
+    // mapped fuzz row for each format
+    std::vector<std::vector<std::vector<uint8_t>>> encoded;
+    std::vector<FuzzTally> tallies;
+    for (const Format& fmt : FORMATS) {
+        encoded.emplace_back();
+        for (const std::vector<uint16_t>& img : images) encoded.back().push_back(fmt.encode(img));
+        tallies.push_back({std::string("fuzz_") + fmt.label});
+        tallies.push_back({std::string("fuzz_") + fmt.label + "_mapped"});
+    }
+
+    char dir[] = "/tmp/osmosis-fuzz-XXXXXX";
+    if (!mkdtemp(dir)) return false;
+    std::string fuzzPath = std::string(dir) + "/fuzz.bin";
+    std::string spiffsRoot = SPIFFS.root();
+    bool stored = useScratchRoot(dir);
+
+    TFT_eSprite ref(&display.tft());
+    ref.setColorDepth(16);
+    ref.createSprite(SCREEN_W, STRIP_H);
+
+    std::mt19937 rng(12345);
+    std::vector<uint16_t> img;
+    for (int i = 0; stored && i < cases; i++) {
+        for (size_t f = 0; stored && f < encoded.size(); f++) {
+            std::vector<uint8_t> data = mutate(encoded[f][i % names.size()], rng);
+            bool refDecoded = referenceDecodeAny(data, img);
+            writeFile(fuzzPath, data);
+            fuzzCheck(tallies[f * 2], ref, "fuzz", refDecoded, img, i);
+            stored = storeAsset("fuzzmap.bin", data);
+            if (stored) fuzzCheck(tallies[f * 2 + 1], ref, "fuzzmap", refDecoded, img, i);
+        }
+    }
+
+    dropScratchRoot(dir, spiffsRoot);
+    if (!stored) fprintf(stderr, "[bench] Failed to store fuzz cases on the assets partition\n");
+    bool ok = stored;
+    printf("\n%-16s %7s %12s %12s %10s\n", "decoder", "cases", "ref ok", "ok", "mismatch");
+    for (const FuzzTally& t : tallies) {
+        printf("%-16s %7d %12u %12u %10u\n", t.label.c_str(), cases, t.refOk, t.curOk, t.mismatches);
+        ok = ok && t.mismatches == 0;
+    }
+    return ok;
+}
+
+bool runImages(int frames) {
+    const int stripsPerImage = LAST_STRIP - FIRST_STRIP + 1;
+
+    TFT_eSprite ref(&display.tft());
+    ref.setColorDepth(16);
+    ref.createSprite(SCREEN_W, STRIP_H);
+
+    // One table row: reference vs renderer draw time over the same strips,
+    // and the most heap the renderer held while preloading and drawing
+    struct DrawTally {
+        std::string label;
+        double refNs = 0, curNs = 0;
+        uint32_t images = 0, mismatches = 0;
+        size_t base = 0, peakHeap = 0;
+    };
+    auto drawImage = [&](DrawTally& t, const std::string& name, const std::vector<uint16_t>& img) {
+        size_t held = hostHeap::inUse() - t.base;
+        hostHeap::resetPeak();
+        if (!imageRenderer::preloadImage(name.c_str())) {
+            fprintf(stderr, "[bench] %s: %s failed to decode\n", t.label.c_str(), name.c_str());
+            t.mismatches++;
+            return;
+        }
+        t.images++;
+        for (int s = FIRST_STRIP; s <= LAST_STRIP; s++) {
+            int stripY = s * STRIP_H;
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; i++) referenceDraw(ref, img, IMG_X, IMG_Y, stripY);
+            auto t1 = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; i++) imageRenderer::drawPreloaded(IMG_X, IMG_Y, stripY);
+            auto t2 = std::chrono::steady_clock::now();
+            t.refNs += std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+            t.curNs += std::chrono::duration<double, std::nano>(t2 - t1).count() / frames;
+
+            if (!stripMatches(ref, img, s)) {
+                if (t.mismatches++ < 5) {
+                    fprintf(stderr, "[bench] %s: %s strip %d differs from reference\n",
+                            t.label.c_str(), name.c_str(), s);
+                }
+            }
+        }
+        size_t peak = held + hostHeap::peakSince();
+        if (peak > t.peakHeap) t.peakHeap = peak;
+    };
+
+    std::vector<std::string> names;
+    std::vector<std::vector<uint16_t>> images;
+    loadCorpus(names, images, true);
+    if (names.empty()) return false;
+
+    // The files in the SPIFFS root, through the decode cache
+    std::vector<DrawTally> tallies(1);
+    tallies[0].label = "draw";
+    imageRenderer::freeBuffer();
+    tallies[0].base = hostHeap::inUse();
+    for (size_t i = 0; i < names.size(); i++) drawImage(tallies[0], names[i], images[i]);
+
+    // Each format on a scratch assets partition: v1 still decodes into the
+    // cache, the row-coded formats draw straight from the mapping
+    bool ok = true;
+    std::string spiffsRoot = SPIFFS.root();
+    std::vector<uint16_t> img;
+    for (const Format& fmt : FORMATS) {
+        DrawTally t;
+        t.label = std::string("draw_") + fmt.label;
+        char dir[] = "/tmp/osmosis-img-XXXXXX";
+        bool stored = mkdtemp(dir) && useScratchRoot(dir);
+        for (size_t i = 0; stored && i < names.size(); i++) {
+            std::vector<uint8_t> data = fmt.encode(images[i]);
+            // The encoder round-trips, so every row draws the same pixels
+            if (!referenceDecodeAny(data, img) || img != images[i]) {
+                fprintf(stderr, "[bench] %s: %s does not round-trip\n", t.label.c_str(), names[i].c_str());
+                t.mismatches++;
+            }
+            stored = storeAsset((names[i] + ".bin").c_str(), data);
+        }
+        if (stored) {
+            imageRenderer::freeBuffer();
+            t.base = hostHeap::inUse();
+            for (size_t i = 0; i < names.size(); i++) drawImage(t, names[i], images[i]);
+        } else {
+            fprintf(stderr, "[bench] %s: failed to store images on the assets partition\n", t.label.c_str());
+            ok = false;
+        }
+        dropScratchRoot(dir, spiffsRoot);
+        tallies.push_back(t);
+    }
+
+    printf("\n%-16s %7s %12s %12s %8s %10s %10s\n",
+           "image", "images", "ref ns/strip", "ns/strip", "speedup", "mismatch", "peak heap");
+    for (const DrawTally& t : tallies) {
+        uint32_t strips = t.images * stripsPerImage;
+        printf("%-16s %7u %12.0f %12.0f %7.1fx %10u %10zu\n", t.label.c_str(), t.images,
+               strips ? t.refNs / strips : 0, strips ? t.curNs / strips : 0,
+               t.curNs > 0 ? t.refNs / t.curNs : 0, t.mismatches, t.peakHeap);
+        ok = ok && t.mismatches == 0 && t.images == names.size();
+    }
+    return ok;
+}
+
+bool runCodec(int rounds) {
+    std::vector<std::string> names;
+    std::vector<std::vector<uint16_t>> images;
+    loadCorpus(names, images, false);
+    if (names.empty()) return false;
+
+    // Every file must be what convert_emoji.py writes for its pixels, so the
+    // encoders here (and the reference decoders) agree with the tool's
+    uint32_t reencoded = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        std::vector<uint8_t> data = readAll(("/" + names[i] + ".bin").c_str());
+        bool same = false;
+        for (const Format& fmt : FORMATS) same = same || fmt.encode(images[i]) == data;
+        if (same) {
+            reencoded++;
+        } else if (i - reencoded < 5) {
+            fprintf(stderr, "[bench] codec: %s does not re-encode identically\n", names[i].c_str());
+        }
+    }
+
+    TFT_eSprite ref(&display.tft());
+    ref.setColorDepth(16);
+    ref.createSprite(SCREEN_W, STRIP_H);
+
+    std::string spiffsRoot = SPIFFS.root();
+    uint32_t failures = 0, mismatches = 0;
+    size_t v1Bytes = 0;
+    printf("\n%-16s %7s %10s %8s %9s %9s %8s %8s %8s %9s\n", "codec", "files", "bytes", "vs v1",
+           "file us", "mapped us", "MB/s", "px/us", "ref MB/s", "mismatch");
+    for (const Format& fmt : FORMATS) {
+        size_t bytes = 0;
+        std::vector<std::vector<uint8_t>> files;
+        for (const std::vector<uint16_t>& img : images) {
+            files.push_back(fmt.encode(img));
+            bytes += files.back().size();
+        }
+
+        // The reference decoders, from memory
+        std::vector<uint16_t> img;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (const std::vector<uint8_t>& data : files) {
+                if (!referenceDecodeAny(data, img) && r == 0) failures++;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double refUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+
+        char dir[] = "/tmp/osmosis-fmt-XXXXXX";
+        if (!mkdtemp(dir) || !useScratchRoot(dir)) {
+            failures++;
+            continue;
+        }
+        // Standalone SPIFFS files, then the same on the assets partition,
+        // which AssetReader prefers
+        std::string label = std::string("codec ") + fmt.label;
+        for (size_t i = 0; i < names.size(); i++) writeFile(std::string(dir) + "/" + names[i] + ".bin", files[i]);
+        double fileUs = timeLoads(names, rounds, failures);
+        uint32_t bad = checkLoads(ref, names, images, (label + " file").c_str());
+        for (size_t i = 0; i < names.size(); i++) {
+            if (!storeAsset((names[i] + ".bin").c_str(), files[i])) failures++;
+        }
+        double mappedUs = timeLoads(names, rounds, failures);
+        bad += checkLoads(ref, names, images, (label + " mapped").c_str());
+        bad += checkLoads(ref, names, images, (label + " prefetched").c_str(), true);
+        dropScratchRoot(dir, spiffsRoot);
+        mismatches += bad;
+
+        if (!v1Bytes) v1Bytes = bytes;
+        printf("%-16s %7zu %10zu %7.1f%% %9.1f %9.1f %8.1f %8.1f %8.1f %9u\n", fmt.label, names.size(),
+               bytes, 100.0 * bytes / v1Bytes, fileUs, mappedUs, bytes / (mappedUs * names.size()),
+               IMG_W * IMG_H / mappedUs, bytes / refUs, bad);
+    }
+    printf("codec: %u of %zu files re-encode identically\n", reencoded, names.size());
+    if (failures) fprintf(stderr, "[bench] codec: %u loads failed\n", failures);
+    return failures == 0 && mismatches == 0 && reencoded == names.size();
+}
+
+}  // namespace bench
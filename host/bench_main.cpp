@@ -0,0 +1,169 @@
+// Host render benchmark (native env).
+//
+//   pio run -e native && .pio/build/native/program [--spiffs data] [--frames 200]
+//                                                  [--png out/] [--cpu-scale 50] [--fuzz 2000]
+//                                                  [--vocab tools/vocab]
+//
+// Renders each screen against the framebuffer stand-in and prints, per
+// screen: frame time, strips and bytes pushed over "SPI", strips skipped by
+// the dirty-region tracker, pixels drawn and the modelled time the CPU sat
+// blocked on SPI ("spi_wait", at ESP32 speed by default, see host/TFT_eSPI.h;
+// --cpu-scale 1 leaves host compose time unscaled). "full" rows force a complete
+// repaint every frame, "idle" rows are the 1 Hz refresh with nothing
+// changed, "next" rows advance a card per frame (card_prefetch also
+// prefetches the next image between frames, untimed). With --png, the last
+// full frame of each screen is written as <screen>.png for golden-image
+// comparison. A second table compares the
+// image draw path against the original renderer and fuzzes the ORLE decoder,
+// a third installs a pack from a local stand-in server one update() at a
+// time, a fourth compares manifest.json and vocab.pack loading (see host/bench.h);
+// the exit status is non-zero if any of them disagree.
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <chrono>
+#include <string>
+#include "bench.h"
+#include "host_png.h"
+#include "display_manager.h"
+#include "dirty_region.h"
+#include "settings_manager.h"
+#include "card_manager.h"
+#include "card_screen.h"
+#include "ui_settings.h"
+#include "image_renderer.h"
+#include "vocab_loader.h"
+
+struct BenchOptions {
+    const char* spiffsDir = "data";
+    const char* pngDir = nullptr;
+    const char* vocabDir = "tools/vocab";
+    int frames = 200;
+    int fuzzCases = 2000;
+};
+
+typedef void (*RenderFn)();
+
+enum class FrameMode { Full, Idle, NextCard };
+
+static void renderSettings() {
+    settingsUI.render();
+}
+
+static void prefetchNextCard() {
+    cardMgr.prefetchNext();
+}
+
+// idle, if given, runs untimed between frames (the main loop's idle work)
+static void runScreen(const char* name, RenderFn fn, FrameMode mode, const BenchOptions& opt,
+                      RenderFn idle = nullptr) {
+    TFT_eSPI& tft = display.tft();
+
+    fn();  // warm-up frame (loads fonts, fills caches)
+    tft.resetStats();
+    uint32_t skippedBefore = dirtyRegion.skippedStrips();
+
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < opt.frames; i++) {
+        if (idle) idle();
+        auto start = std::chrono::steady_clock::now();
+        if (mode == FrameMode::Full) dirtyRegion.markAll();
+        else if (mode == FrameMode::NextCard) cardMgr.nextCard();
+        fn();
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    double us = std::chrono::duration<double, std::micro>(elapsed).count() / opt.frames;
+    const TFT_HostStats& st = tft.stats();
+    printf("%-16s %7d %10.1f %10.1f %8.1f %8.1f %10.0f %10.0f\n", name, opt.frames, us,
+           (double)st.spiWaitUs / opt.frames,
+           (double)st.pushes / opt.frames,
+           (double)(dirtyRegion.skippedStrips() - skippedBefore) / opt.frames,
+           (double)st.pushBytes / opt.frames,
+           (double)st.pixelsDrawn / opt.frames);
+    if (st.dmaHazards) {
+        fprintf(stderr, "[bench] %s: %u writes into a strip still being sent by DMA\n",
+                name, st.dmaHazards);
+    }
+
+    if (opt.pngDir && mode == FrameMode::Full) {
+        std::string path = std::string(opt.pngDir) + "/" + name + ".png";
+        if (!hostPng::writeRgb565(path.c_str(), tft.framebuffer(), tft.width(), tft.height())) {
+            fprintf(stderr, "[bench] Failed to write %s\n", path.c_str());
+        }
+    }
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--spiffs" && i + 1 < argc) opt.spiffsDir = argv[++i];
+        else if (a == "--png" && i + 1 < argc) opt.pngDir = argv[++i];
+        else if (a == "--frames" && i + 1 < argc) opt.frames = atoi(argv[++i]);
+        else if (a == "--vocab" && i + 1 < argc) opt.vocabDir = argv[++i];
+        else if (a == "--fuzz" && i + 1 < argc) opt.fuzzCases = atoi(argv[++i]);
+        else if (a == "--cpu-scale" && i + 1 < argc) TFT_eSPI::hostCpuScale = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--spiffs DIR] [--frames N] [--png DIR] [--cpu-scale N] [--fuzz N]\n"
+                            "       [--vocab DIR]\n", argv[0]);
+            return false;
+        }
+    }
+    if (opt.frames < 1) opt.frames = 1;
+    if (TFT_eSPI::hostCpuScale < 1) TFT_eSPI::hostCpuScale = 1;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    Serial.setQuiet(getenv("OSMOSIS_VERBOSE") == nullptr);
+    SPIFFS.setRoot(opt.spiffsDir);
+    if (!SPIFFS.begin()) {
+        fprintf(stderr, "[bench] SPIFFS root '%s' not found\n", opt.spiffsDir);
+        return 1;
+    }
+
+    // Synchronous strip pushes first, for comparison with the DMA pipeline
+    TFT_eSPI::hostDmaSupported = false;
+    display.init();
+    settingsMgr.init();
+    imageRenderer::init();
+    if (!vocabLoader::load()) {
+        fprintf(stderr, "[bench] No pack in '%s' (need manifest.json)\n", opt.spiffsDir);
+        return 1;
+    }
+    cardMgr.init();
+    cardScreen::init();
+
+    printf("%-16s %7s %10s %10s %8s %8s %10s %10s\n",
+           "screen", "frames", "us/frame", "spi_wait", "strips", "skipped", "bytes", "pixels");
+
+    settingsMgr.settings().showPhonetic = false;
+    runScreen("card_sync", cardScreen::render, FrameMode::Full, opt);
+
+    TFT_eSPI::hostDmaSupported = true;
+    display.init();
+    runScreen("card", cardScreen::render, FrameMode::Full, opt);
+    runScreen("card_idle", cardScreen::render, FrameMode::Idle, opt);
+    runScreen("card_next", cardScreen::render, FrameMode::NextCard, opt);
+    uint32_t hits = imageRenderer::cacheHits(), misses = imageRenderer::cacheMisses();
+    runScreen("card_prefetch", cardScreen::render, FrameMode::NextCard, opt, prefetchNextCard);
+    hits = imageRenderer::cacheHits() - hits;
+    misses = imageRenderer::cacheMisses() - misses;
+    settingsMgr.settings().showPhonetic = true;
+    runScreen("card_phonetic", cardScreen::render, FrameMode::Full, opt);
+
+    settingsUI.show();
+    runScreen("settings", renderSettings, FrameMode::Full, opt);
+    runScreen("settings_idle", renderSettings, FrameMode::Idle, opt);
+    settingsUI.hide();
+    printf("card_prefetch image cache: %u hits, %u misses\n", hits, misses);
+
+    bool ok = bench::runImages(opt.frames);
+    ok = bench::runCodec(opt.frames) && ok;
+    ok = bench::fuzzDecoder(opt.fuzzCases) && ok;
+    ok = bench::runDownload((std::string(opt.vocabDir) + "/../build_pack.py").c_str()) && ok;
+    ok = bench::runVocab(opt.vocabDir) && ok;  // Last: replaces the loaded pack
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+#include "bench.h"
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include <unistd.h>
+#include "constants.h"
+#include "host_heap.h"
+#include "vocab_loader.h"
+
+static const int LOAD_REPEATS = 20;
+static const size_t FIXED_ENTRY_BYTES = 32 + 32 + 40 + 12 + 16;  // Former char-array WordEntry
+static const uint16_t SYNTHETIC_WORDS = 5000;
+
+struct LoadResult {
+    bool ok = false;
+    size_t fileBytes = 0;
+    double us = 0;
+    size_t peakHeap = 0;
+    size_t residentBytes = 0;
+    std::vector<std::string> words;  // Fields joined with '|'
+};
+
+struct Totals {
+    uint32_t packs = 0;
+    uint32_t mismatches = 0;
+    double jsonUs = 0;
+    double packUs = 0;
+    size_t jsonHeap = 0;
+    size_t packHeap = 0;
+    size_t ram = 0;
+    size_t oldRam = 0;
+};
+
+static size_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static bool copyFile(const std::string& from, const std::string& to) {
+    FILE* in = fopen(from.c_str(), "rb");
+    if (!in) return false;
+    FILE* out = fopen(to.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) fwrite(buf, 1, n, out);
+    fclose(in);
+    return fclose(out) == 0;
+}
+
+// Boot-time vocab work: open the pack and read a default-sized daily batch
+// spread over the whole pack
+static bool loadAndBatch() {
+    if (!vocabLoader::load()) return false;
+    uint16_t count = vocabLoader::wordCount();
+    uint16_t indices[DEFAULT_WORDS_PER_DAY];
+    for (int i = 0; i < DEFAULT_WORDS_PER_DAY; i++) {
+        indices[i] = (uint16_t)((uint32_t)i * count / DEFAULT_WORDS_PER_DAY);
+    }
+    return vocabLoader::loadBatch(indices, DEFAULT_WORDS_PER_DAY);
+}
+
+// Every word of the loaded pack, read batch by batch
+static std::vector<std::string> readAllWords() {
+    std::vector<std::string> words;
+    uint16_t count = vocabLoader::wordCount();
+    for (uint32_t first = 0; first < count; first += MAX_BATCH_WORDS) {
+        uint16_t indices[MAX_BATCH_WORDS];
+        uint8_t n = 0;
+        for (uint32_t i = first; i < count && n < MAX_BATCH_WORDS; i++) indices[n++] = (uint16_t)i;
+        if (!vocabLoader::loadBatch(indices, n)) return {};
+        for (uint8_t i = 0; i < n; i++) {
+            const WordEntry& w = vocabLoader::batchWord(i);
+            words.push_back(std::string(w.word()) + "|" + w.english() + "|" + w.phonetic() + "|" +
+                            w.emoji() + "|" + w.category());
+        }
+    }
+    return words;
+}
+
+// loadAndBatch() with `dir` as the SPIFFS root: peak heap of the first run,
+// mean time over LOAD_REPEATS. fromJson removes vocab.pack before every run,
+// so the loader has to build it from manifest.json each time.
+static LoadResult timeLoad(const std::string& dir, const char* file, bool fromJson) {
+    LoadResult r;
+    std::string pack = dir + "/vocab.pack";
+    r.fileBytes = fileSize(dir + "/" + file);
+    SPIFFS.setRoot(dir.c_str());
+
+    if (fromJson) unlink(pack.c_str());
+    hostHeap::resetPeak();
+    r.ok = loadAndBatch();
+    r.peakHeap = hostHeap::peakSince();
+    if (!r.ok) return r;
+    r.residentBytes = vocabLoader::heapBytes();
+
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < LOAD_REPEATS; i++) {
+        if (fromJson) unlink(pack.c_str());
+        auto t0 = std::chrono::steady_clock::now();
+        loadAndBatch();
+        elapsed += std::chrono::steady_clock::now() - t0;
+    }
+    r.us = std::chrono::duration<double, std::micro>(elapsed).count() / LOAD_REPEATS;
+
+    r.words = readAllWords();
+    return r;
+}
+
+static std::vector<std::string> listCsv(const char* dir) {
+    std::vector<std::string> names;
+    if (DIR* d = opendir(dir)) {
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".csv") == 0) {
+                names.push_back(name.substr(0, name.size() - 4));
+            }
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// Vocab CSV in tools/vocab format with generated words of mixed lengths
+static bool writeSyntheticCsv(const std::string& path, uint16_t words) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "emoji,english,translation,phonetic,category\n");
+    for (uint32_t i = 0; i < words; i++) {
+        fprintf(f, "%x,thing %u,palabra%u%s,pah-LAH-brah-%u,category%u\n", 0x1f300 + (i % 700),
+                i, i, (i % 7 == 0) ? "-compuesta-larga" : "", i, i % 12);
+    }
+    return fclose(f) == 0;
+}
+
+// Builds one pack with build_pack.py and prints its row; false if skipped
+static bool benchPack(const std::string& label, const std::string& csv, const std::string& tier,
+                      const std::string& buildPack, const std::string& jsonDir,
+                      const std::string& packDir, Totals& t) {
+    // <language>_<tier>, where the language may itself contain '_'
+    std::string language = label.substr(0, label.size() - tier.size() - 1);
+    std::string cmd = "python3 '" + buildPack + "' --csv '" + csv + "' --output '" + packDir +
+                      "' --language '" + language + "' --tier '" + tier + "' >/dev/null 2>&1";
+    if (system(cmd.c_str()) != 0 ||
+        !copyFile(packDir + "/manifest.json", jsonDir + "/manifest.json")) {
+        fprintf(stderr, "[bench] Skipping %s (build_pack.py failed)\n", label.c_str());
+        return false;
+    }
+
+    LoadResult json = timeLoad(jsonDir, "manifest.json", true);
+    LoadResult pack = timeLoad(packDir, "vocab.pack", false);
+    bool same = json.ok && pack.ok && !pack.words.empty() && json.words == pack.words;
+    size_t oldRam = pack.words.size() * FIXED_ENTRY_BYTES;
+
+    t.packs++;
+    t.mismatches += !same;
+    t.jsonUs += json.us;
+    t.packUs += pack.us;
+    t.jsonHeap = std::max(t.jsonHeap, json.peakHeap);
+    t.packHeap = std::max(t.packHeap, pack.peakHeap);
+    t.ram += pack.residentBytes;
+    t.oldRam += oldRam;
+
+    printf("%-24s %5u %8u %8.1f %9u %8u %8.1f %9u %7u %7u %5s\n", label.c_str(),
+           (unsigned)pack.words.size(), (unsigned)json.fileBytes, json.us,
+           (unsigned)json.peakHeap, (unsigned)pack.fileBytes, pack.us,
+           (unsigned)pack.peakHeap, (unsigned)pack.residentBytes, (unsigned)oldRam,
+           same ? "yes" : "NO");
+    return true;
+}
+
+namespace bench {
+
+bool runVocab(const char* vocabDir) {
+    std::vector<std::string> names = listCsv(vocabDir);
+    if (names.empty()) {
+        fprintf(stderr, "[bench] No vocab CSVs in '%s', skipping pack load comparison\n", vocabDir);
+        return true;
+    }
+
+    char tmp[] = "/tmp/osmosis-vocab-XXXXXX";
+    if (!mkdtemp(tmp)) return false;
+    std::string jsonDir = std::string(tmp) + "/json";
+    std::string packDir = std::string(tmp) + "/pack";
+    std::string synthCsv = std::string(tmp) + "/synthetic_5000.csv";
+    mkdir(jsonDir.c_str(), 0755);
+    mkdir(packDir.c_str(), 0755);
+    std::string buildPack = std::string(vocabDir) + "/../build_pack.py";
+    std::string spiffsRoot = SPIFFS.root();
+
+    printf("\n%-24s %5s %8s %8s %9s %8s %8s %9s %7s %7s %5s\n", "vocab", "words",
+           "json B", "json us", "json heap", "pack B", "pack us", "pack heap",
+           "ram", "old ram", "same");
+
+    Totals t;
+    for (const std::string& name : names) {
+        size_t split = name.rfind('_');
+        if (split == std::string::npos) continue;
+        benchPack(name, std::string(vocabDir) + "/" + name + ".csv", name.substr(split + 1),
+                  buildPack, jsonDir, packDir, t);
+    }
+    if (t.packs > 0) {
+        printf("%-24s %5u %8s %8.1f %9u %8s %8.1f %9u %7u %7u %5u\n", "mean / max heap", t.packs, "",
+               t.jsonUs / t.packs, (unsigned)t.jsonHeap, "", t.packUs / t.packs,
+               (unsigned)t.packHeap, (unsigned)(t.ram / t.packs), (unsigned)(t.oldRam / t.packs),
+               t.mismatches);
+    }
+
+    // Resident memory has to stay flat however big the tier is
+    Totals synth;
+    if (!writeSyntheticCsv(synthCsv, SYNTHETIC_WORDS) ||
+        !benchPack("synthetic_5000", synthCsv, "5000", buildPack, jsonDir, packDir, synth)) {
+        synth.mismatches = 1;
+    }
+    SPIFFS.setRoot(spiffsRoot.c_str());
+
+    for (const char* f : {"/json/manifest.json", "/json/vocab.pack", "/pack/manifest.json",
+                          "/pack/vocab.pack", "/synthetic_5000.csv"}) {
+        unlink((std::string(tmp) + f).c_str());
+    }
+    rmdir(jsonDir.c_str());
+    rmdir(packDir.c_str());
+    rmdir(tmp);
+
+    if (!hostHeap::enabled()) fprintf(stderr, "[bench] Heap tracking is off in sanitizer builds\n");
+    return t.mismatches == 0 && synth.mismatches == 0;
+}
+
+}  // namespace bench
@@ -0,0 +1,56 @@
+#pragma once
+// Host stand-in for the ESP-IDF partition API (native env only).
+//
+// The table holds the data partitions of partitions_ota.csv. Each is backed
+// by <SPIFFS root>/<label>.part, created erased (0xFF) on first use, so a
+// bench device directory holds all of its flash; the host FS leaves these
+// files out of SPIFFS listings and usage. Writes can only clear bits, as on
+// NOR flash, and erases must cover whole sectors. A mapping is an mmap() of
+// the file, so writes show through it as they do through the flash cache.
+#include <cstddef>
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK               0
+#define ESP_FAIL             -1
+#define ESP_ERR_INVALID_ARG  0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_DATA_SPIFFS = 0x82,
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef enum { SPI_FLASH_MMAP_DATA, SPI_FLASH_MMAP_INST } spi_flash_mmap_memory_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size);
+esp_err_t esp_partition_mmap(const esp_partition_t* part, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** out_ptr,
+                             spi_flash_mmap_handle_t* out_handle);
+void spi_flash_munmap(spi_flash_mmap_handle_t handle);
+
+// Host only: size the table gives partition `label` from now on, e.g. a
+// smaller one to leave no room to spare. Bytes past it stay in the file.
+void hostSetPartitionSize(const char* label, uint32_t size);
+uint32_t hostPartitionTableSize(const char* label);  // As in partitions_ota.csv
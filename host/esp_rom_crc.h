@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for the ESP32 ROM CRC routines (native env only).
+#include <cstdint>
+
+// CRC-32 as zlib computes it, continued from crc (0 to start)
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
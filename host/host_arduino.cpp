@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include <Esp.h>
+#include <esp_rom_crc.h>
+#include <chrono>
+
+HostSerial Serial;
+EspClass ESP;
+
+// delay() advances a virtual clock instead of sleeping, so timers in the
+// firmware still fire while benchmarks run at full speed.
+static uint64_t _virtualUs = 0;
+
+static uint64_t hostMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+           + _virtualUs;
+}
+
+uint32_t millis() { return (uint32_t)(hostMicros() / 1000); }
+uint32_t micros() { return (uint32_t)hostMicros(); }
+void delay(uint32_t ms) { _virtualUs += (uint64_t)ms * 1000; }
+void yield() {}
+
+// Deterministic PRNG so host renders are reproducible run to run
+static uint32_t _rngState = 0x12345678;
+
+void randomSeed(unsigned long seed) {
+    _rngState = seed ? (uint32_t)seed : 0x12345678;
+}
+
+long random(long max) {
+    if (max <= 0) return 0;
+    _rngState ^= _rngState << 13;
+    _rngState ^= _rngState >> 17;
+    _rngState ^= _rngState << 5;
+    return (long)(_rngState % (uint32_t)max);
+}
+
+long random(long min, long max) {
+    if (max <= min) return min;
+    return min + random(max - min);
+}
+
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = (len >= size) ? size - 1 : len;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+// -------------------------------------------------------
+// Serial goes to stderr so benchmark output on stdout stays machine-readable
+size_t HostSerial::printf(const char* fmt, ...) {
+    if (_quiet) return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vfprintf(stderr, fmt, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t HostSerial::print(const char* s) {
+    if (_quiet) return 0;
+    return fputs(s, stderr) < 0 ? 0 : strlen(s);
+}
+
+size_t HostSerial::println(const char* s) {
+    if (_quiet) return 0;
+    return (size_t)fprintf(stderr, "%s\n", s);
+}
+
+// -------------------------------------------------------
+// Nominal ESP32 heap figures; the host has no meaningful equivalent
+uint32_t EspClass::getFreeHeap() { return 200 * 1024; }
+uint32_t EspClass::getMaxAllocHeap() { return 110 * 1024; }
+
+void EspClass::restart() {
+    Serial.println("[host] ESP.restart() requested, exiting");
+    exit(0);
+}
+
+// -------------------------------------------------------
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
@@ -0,0 +1,199 @@
+#include <FS.h>
+#include <SPIFFS.h>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+fs::FS SPIFFS;
+
+namespace fs {
+
+// <label>.part files back raw partitions (host/esp_partition.h), not SPIFFS
+static bool isPartitionImage(const char* name) {
+    size_t n = strlen(name);
+    return n > 5 && strcmp(name + n - 5, ".part") == 0;
+}
+
+struct File::Impl {
+    FILE* fp = nullptr;
+    DIR* dir = nullptr;
+    std::string hostPath;
+    std::string name;  // Path as seen by firmware ("/foo.bin")
+    std::string root;  // Only set for directory handles
+
+    ~Impl() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    return fread(buf, 1, size, _impl->fp);
+}
+
+int File::read() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    if (c == EOF) return -1;
+    ungetc(c, _impl->fp);
+    return c;
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    return fwrite(buf, 1, size, _impl->fp);
+}
+
+int File::available() {
+    if (!_impl || !_impl->fp) return 0;
+    return (int)(size() - position());
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_impl || !_impl->fp) return false;
+    int whence = (mode == SeekCur) ? SEEK_CUR : (mode == SeekEnd) ? SEEK_END : SEEK_SET;
+    return fseek(_impl->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->fp) return 0;
+    long p = ftell(_impl->fp);
+    return p < 0 ? 0 : (size_t)p;
+}
+
+size_t File::size() const {
+    if (!_impl || !_impl->fp) return 0;
+    struct stat st;
+    fflush(_impl->fp);
+    if (fstat(fileno(_impl->fp), &st) != 0) return 0;
+    return (size_t)st.st_size;
+}
+
+void File::flush() {
+    if (_impl && _impl->fp) fflush(_impl->fp);
+}
+
+void File::close() {
+    _impl.reset();
+}
+
+const char* File::name() const {
+    return _impl ? _impl->name.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return _impl && _impl->dir;
+}
+
+File File::openNextFile() {
+    File f;
+    if (!_impl || !_impl->dir) return f;
+    struct dirent* ent;
+    while ((ent = readdir(_impl->dir)) != nullptr) {
+        if (ent->d_name[0] == '.' || isPartitionImage(ent->d_name)) continue;
+        std::string hostPath = _impl->root + "/" + ent->d_name;
+        struct stat st;
+        if (stat(hostPath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        f._impl = std::make_shared<Impl>();
+        f._impl->fp = fopen(hostPath.c_str(), "rb");
+        f._impl->hostPath = hostPath;
+        f._impl->name = std::string("/") + ent->d_name;
+        return f;
+    }
+    return f;
+}
+
+File::operator bool() const {
+    return _impl && (_impl->fp || _impl->dir);
+}
+
+// -------------------------------------------------------
+bool FS::begin(bool formatOnFail) {
+    struct stat st;
+    if (stat(_root.c_str(), &st) == 0) return S_ISDIR(st.st_mode);
+    return formatOnFail && mkdir(_root.c_str(), 0755) == 0;
+}
+
+void FS::setRoot(const char* dir) {
+    _root = dir;
+}
+
+std::string FS::hostPath(const char* path) const {
+    if (path[0] == '/') return _root + path;
+    return _root + "/" + path;
+}
+
+File FS::open(const char* path, const char* mode) {
+    File f;
+    std::string hp = hostPath(path);
+
+    if (strcmp(path, "/") == 0) {
+        DIR* d = opendir(_root.c_str());
+        if (!d) return f;
+        f._impl = std::make_shared<File::Impl>();
+        f._impl->dir = d;
+        f._impl->root = _root;
+        f._impl->name = "/";
+        return f;
+    }
+
+    const char* fmode = "rb";
+    if (mode[0] == 'w') fmode = "wb";
+    else if (mode[0] == 'a') fmode = "ab";
+    else if (mode[0] == 'r' && mode[1] == '+') fmode = "r+b";
+
+    FILE* fp = fopen(hp.c_str(), fmode);
+    if (!fp) return f;
+    f._impl = std::make_shared<File::Impl>();
+    f._impl->fp = fp;
+    f._impl->hostPath = hp;
+    f._impl->name = path;
+    hostOpens++;
+    return f;
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+// Defaults to the 0x70000-byte spiffs partition from partitions_ota.csv
+size_t FS::hostTotalBytes = 0x70000;
+uint32_t FS::hostOpens = 0;
+
+size_t FS::totalBytes() {
+    return hostTotalBytes;
+}
+
+size_t FS::usedBytes() {
+    size_t used = 0;
+    DIR* d = opendir(_root.c_str());
+    if (!d) return 0;
+    struct dirent* ent;
+    while ((ent = readdir(d)) != nullptr) {
+        if (isPartitionImage(ent->d_name)) continue;
+        struct stat st;
+        std::string hp = _root + "/" + ent->d_name;
+        if (stat(hp.c_str(), &st) == 0 && S_ISREG(st.st_mode)) used += (size_t)st.st_size;
+    }
+    closedir(d);
+    return used;
+}
+
+}  // namespace fs
@@ -0,0 +1,78 @@
+#include "host_heap.h"
+#include <malloc.h>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define HOST_HEAP_TRACKING 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define HOST_HEAP_TRACKING 0
+#endif
+#endif
+#ifndef HOST_HEAP_TRACKING
+#define HOST_HEAP_TRACKING 1
+#endif
+
+static size_t inUseBytes = 0;
+static size_t peakBytes = 0;
+static size_t baseBytes = 0;
+
+#if HOST_HEAP_TRACKING
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+
+static void track(void* p) {
+    if (!p) return;
+    inUseBytes += malloc_usable_size(p);
+    if (inUseBytes > peakBytes) peakBytes = inUseBytes;
+}
+
+static void untrack(void* p) {
+    if (p) inUseBytes -= malloc_usable_size(p);
+}
+
+void* malloc(size_t size) {
+    void* p = __libc_malloc(size);
+    track(p);
+    return p;
+}
+
+void* calloc(size_t n, size_t size) {
+    void* p = __libc_calloc(n, size);
+    track(p);
+    return p;
+}
+
+void* realloc(void* p, size_t size) {
+    untrack(p);
+    void* q = __libc_realloc(p, size);
+    track(q ? q : (size ? p : nullptr));
+    return q;
+}
+
+void free(void* p) {
+    untrack(p);
+    __libc_free(p);
+}
+}  // extern "C"
+
+#endif  // HOST_HEAP_TRACKING
+
+namespace hostHeap {
+
+bool enabled() { return HOST_HEAP_TRACKING; }
+size_t inUse() { return inUseBytes; }
+
+void resetPeak() {
+    baseBytes = inUseBytes;
+    peakBytes = inUseBytes;
+}
+
+size_t peakSince() {
+    return peakBytes - baseBytes;
+}
+
+}  // namespace hostHeap
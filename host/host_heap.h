@@ -0,0 +1,15 @@
+#pragma once
+// Host only: heap accounting for benchmarks (native env).
+//
+// malloc/calloc/realloc/free are wrapped so benchmarks can measure the peak
+// heap a call needs, the number an ESP32 with a fragmented heap cares about.
+// Counts usable block sizes, so small allocations read slightly high.
+// Sanitizer builds keep their own allocator and report 0.
+#include <cstddef>
+
+namespace hostHeap {
+    bool enabled();
+    size_t inUse();
+    void resetPeak();       // Start a measurement at the current use
+    size_t peakSince();     // Highest use above the resetPeak() level
+}
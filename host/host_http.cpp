@@ -0,0 +1,214 @@
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <cstdio>
+#include <strings.h>
+#include <sys/stat.h>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+size_t WiFiClient::hostSegment = 1436;  // One Ethernet-sized TCP segment
+uint32_t HTTPClient::hostRequests = 0;
+uint32_t HTTPClient::hostConnects = 0;
+uint32_t HTTPClient::hostHandshakeMs = 0;
+uint32_t HTTPClient::hostRequestMs = 0;
+uint32_t HTTPClient::hostKeepAliveMax = 0;
+bool HTTPClient::hostSilentClose = false;
+bool HTTPClient::hostChunked = false;
+uint32_t HTTPClient::hostCutEvery = 0;
+uint32_t HTTPClient::hostNotModified = 0;
+uint32_t HTTPClient::hostCorruptEvery = 0;
+const char* HTTPClient::hostCorruptMatch = "";
+uint32_t HTTPClient::hostCorrupted = 0;
+static uint32_t _corruptMatches = 0;  // Responses hostCorruptMatch picked out so far
+
+static std::vector<std::pair<std::string, std::string>> _mounts;  // URL prefix, directory
+
+// -------------------------------------------------------
+int WiFiClient::available() {
+    // The next segment arrives once the previous one has been read
+    if (_ready == 0) {
+        size_t left = _body.size() - _pos;
+        _ready = left < hostSegment ? left : hostSegment;
+    }
+    return (int)_ready;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    size_t n = size < _ready ? size : _ready;
+    memcpy(buf, _body.data() + _pos, n);
+    _pos += n;
+    _ready -= n;
+    return (int)n;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+void WiFiClient::stop() {
+    _body.clear();
+    _pos = 0;
+    _ready = 0;
+    _open = false;
+    _closeAfterBody = false;
+    _stale = false;
+    _served = 0;
+}
+
+// -------------------------------------------------------
+static bool readFile(const std::string& path, std::string& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// Body in chunks of up to 1000 bytes, with an extension on the first
+static std::string encodeChunked(const std::string& body) {
+    std::string out;
+    char line[32];
+    for (size_t pos = 0; pos < body.size(); pos += 1000) {
+        size_t n = body.size() - pos < 1000 ? body.size() - pos : 1000;
+        snprintf(line, sizeof(line), pos == 0 ? "%zx;host=1\r\n" : "%zX\r\n", n);
+        out += line;
+        out.append(body, pos, n);
+        out += "\r\n";
+    }
+    out += "0\r\n\r\n";
+    return out;
+}
+
+// Quoted FNV-1a of the content, like a strong server ETag
+static std::string makeEtag(const std::string& content) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : content) h = (h ^ c) * 16777619u;
+    char buf[16];
+    snprintf(buf, sizeof(buf), "\"%08x\"", h);
+    return buf;
+}
+
+static std::string httpDate(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return "";
+    char buf[32];
+    struct tm tm;
+    gmtime_r(&st.st_mtime, &tm);
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+bool HTTPClient::begin(WiFiClient& client, const char* url) {
+    _client = &client;
+    _url = url;
+    _size = -1;
+    _chunked = false;
+    _content.clear();
+    _ifNoneMatch.clear();
+    _ifModifiedSince.clear();
+    _etag.clear();
+    _lastModified.clear();
+    return true;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    if (strcasecmp(name.c_str(), "If-None-Match") == 0) _ifNoneMatch = value;
+    else if (strcasecmp(name.c_str(), "If-Modified-Since") == 0) _ifModifiedSince = value;
+}
+
+void HTTPClient::end() {
+    // A connection with unread response bytes can't carry another request
+    if (_client && (!_reuse || _client->_pos < _client->_body.size())) _client->stop();
+    _client = nullptr;
+}
+
+int HTTPClient::GET() {
+    hostRequests++;
+    if (!_client) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    const std::pair<std::string, std::string>* mount = nullptr;
+    for (const auto& m : _mounts) {
+        if (_url.compare(0, m.first.size(), m.first) == 0) mount = &m;
+    }
+    if (!mount) {
+        _client->stop();
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    if (_client->_stale) {
+        _client->stop();
+        return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    if (!_client->connected()) {
+        _client->stop();
+        _client->_open = true;
+        hostConnects++;
+        delay(hostHandshakeMs);
+    }
+    delay(hostRequestMs);
+
+    _client->_body.clear();
+    _client->_pos = 0;
+    _client->_ready = 0;
+    if (hostKeepAliveMax && ++_client->_served >= hostKeepAliveMax) {
+        if (hostSilentClose) _client->_stale = true;
+        else _client->_closeAfterBody = true;
+    }
+
+    std::string path = mount->second + _url.substr(mount->first.size());
+    if (!readFile(path, _content)) {
+        _client->_body = "Not found";
+        _size = (int)_client->_body.size();
+        return 404;
+    }
+    _etag = makeEtag(_content);
+    _lastModified = httpDate(path);
+    bool notModified = _ifNoneMatch.empty() ? (!_ifModifiedSince.empty() && _ifModifiedSince == _lastModified)
+                                            : _ifNoneMatch == _etag;
+    if (notModified) {
+        hostNotModified++;
+        _content.clear();
+        _size = 0;
+        return 304;
+    }
+    if (hostCorruptEvery && !_content.empty() && _url.find(hostCorruptMatch) != std::string::npos &&
+        _corruptMatches++ % hostCorruptEvery == 0) {
+        _content[_content.size() / 4] ^= 0x20;
+        _content[_content.size() * 3 / 4] ^= 0x20;
+        hostCorrupted++;
+    }
+    _chunked = hostChunked;
+    _client->_body = _chunked ? encodeChunked(_content) : _content;
+    _size = _chunked ? -1 : (int)_content.size();
+    if (hostCutEvery && hostRequests % hostCutEvery == 0) {
+        _client->_body.resize(_client->_body.size() / 2);
+        _client->_closeAfterBody = true;
+    }
+    return 200;
+}
+
+String HTTPClient::header(const char* name) {
+    if (strcasecmp(name, "ETag") == 0) return String(_etag);
+    if (strcasecmp(name, "Last-Modified") == 0) return String(_lastModified);
+    return String(_chunked && strcasecmp(name, "Transfer-Encoding") == 0 ? "chunked" : "");
+}
+
+String HTTPClient::getString() {
+    if (!_client) return String();
+    _client->_pos = _client->_body.size();  // Consumes the response
+    _client->_ready = 0;
+    return String(_content);
+}
+
+void HTTPClient::hostMount(const char* prefix, const char* dir) {
+    _mounts.emplace_back(prefix, dir);
+}
+
+void HTTPClient::hostUnmountAll() {
+    _mounts.clear();
+}
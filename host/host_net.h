@@ -0,0 +1,6 @@
+#pragma once
+// Host-only controls for the network stand-ins (native env only).
+namespace hostNet {
+    // What wifiMgr reports; the host build starts disconnected
+    void setWifiConnected(bool connected);
+}
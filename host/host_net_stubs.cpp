@@ -0,0 +1,26 @@
+// Offline stand-in for the Wi-Fi module (native env only).
+// The host build has no radio: the settings UI sees a device that was never
+// configured unless a benchmark marks it connected, and HTTP goes to the
+// HTTPClient stand-in (see host/HTTPClient.h).
+#include "wifi_manager.h"
+#include "host_net.h"
+#include <Arduino.h>
+
+static bool _connected = false;
+
+namespace hostNet {
+    void setWifiConnected(bool connected) { _connected = connected; }
+}
+
+namespace wifiMgr {
+    void init() {}
+    void startCaptivePortal() {}
+    void stopCaptivePortal() {}
+    void connect() {}
+    void disconnect() {}
+    void update() {}
+    WiFiState state() { return _connected ? WiFiState::Connected : WiFiState::NotConfigured; }
+    bool isConnected() { return _connected; }
+    const char* ssid() { return _connected ? "host" : ""; }
+    int8_t rssi() { return _connected ? -50 : 0; }
+}
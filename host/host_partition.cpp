@@ -0,0 +1,131 @@
+#include <esp_partition.h>
+#include <SPIFFS.h>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Data partitions of partitions_ota.csv
+static esp_partition_t partitions[] = {
+    {ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x290000, 0x100000, "assets", false},
+    {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x390000, 0x70000, "spiffs", false},
+};
+static const uint32_t tableSizes[] = {0x100000, 0x70000};
+static const size_t PARTITION_COUNT = sizeof(partitions) / sizeof(partitions[0]);
+
+struct Mapping {
+    void* addr;
+    size_t len;
+};
+static std::map<spi_flash_mmap_handle_t, Mapping> mappings;
+static spi_flash_mmap_handle_t nextHandle = 1;
+
+static bool inRange(const esp_partition_t* part, size_t offset, size_t size) {
+    return part && offset <= part->size && size <= part->size - offset;
+}
+
+// The partition's backing file, created erased and at least part->size long
+static int openImage(const esp_partition_t* part) {
+    std::string path = std::string(SPIFFS.root()) + "/" + part->label + ".part";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < part->size) {
+        std::vector<uint8_t> erased(part->size - st.st_size, 0xFF);
+        if (pwrite(fd, erased.data(), erased.size(), st.st_size) != (ssize_t)erased.size()) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char* label) {
+    for (esp_partition_t& p : partitions) {
+        if (p.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p.subtype != subtype) continue;
+        if (label && strcmp(p.label, label) != 0) continue;
+        return &p;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size) {
+    if (!inRange(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+    int fd = openImage(part);
+    if (fd < 0) return ESP_FAIL;
+    bool ok = pread(fd, dst, size, offset) == (ssize_t)size;
+    close(fd);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* src, size_t size) {
+    if (!inRange(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+    int fd = openImage(part);
+    if (fd < 0) return ESP_FAIL;
+    // Programming only clears bits: unerased bytes end up ANDed
+    std::vector<uint8_t> cells(size);
+    bool ok = pread(fd, cells.data(), size, offset) == (ssize_t)size;
+    for (size_t i = 0; ok && i < size; i++) cells[i] &= ((const uint8_t*)src)[i];
+    ok = ok && pwrite(fd, cells.data(), size, offset) == (ssize_t)size;
+    close(fd);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size) {
+    if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+    if (!inRange(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+    int fd = openImage(part);
+    if (fd < 0) return ESP_FAIL;
+    std::vector<uint8_t> erased(size, 0xFF);
+    bool ok = pwrite(fd, erased.data(), size, offset) == (ssize_t)size;
+    close(fd);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* part, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** out_ptr,
+                             spi_flash_mmap_handle_t* out_handle) {
+    (void)memory;
+    if (!inRange(part, offset, size) || size == 0) return ESP_ERR_INVALID_SIZE;
+    int fd = openImage(part);
+    if (fd < 0) return ESP_FAIL;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t skew = offset % page;
+    void* addr = mmap(nullptr, size + skew, PROT_READ, MAP_SHARED, fd, offset - skew);
+    close(fd);
+    if (addr == MAP_FAILED) return ESP_FAIL;
+    mappings[nextHandle] = {addr, size + skew};
+    *out_handle = nextHandle++;
+    *out_ptr = (const uint8_t*)addr + skew;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    auto it = mappings.find(handle);
+    if (it == mappings.end()) return;
+    munmap(it->second.addr, it->second.len);
+    mappings.erase(it);
+}
+
+void hostSetPartitionSize(const char* label, uint32_t size) {
+    for (esp_partition_t& p : partitions) {
+        if (strcmp(p.label, label) == 0) p.size = size;
+    }
+}
+
+uint32_t hostPartitionTableSize(const char* label) {
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        if (strcmp(partitions[i].label, label) == 0) return tableSizes[i];
+    }
+    return 0;
+}
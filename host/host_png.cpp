@@ -0,0 +1,100 @@
+#include "host_png.h"
+#include <cstdio>
+#include <vector>
+
+// Minimal PNG encoder: zlib stream made of stored (uncompressed) deflate
+// blocks, so no zlib dependency. Output is large but byte-stable, which is
+// what golden-image comparisons need.
+
+static uint32_t crcTable[256];
+
+static void initCrc() {
+    static bool ready = false;
+    if (ready) return;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+    ready = true;
+}
+
+static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putU32(std::vector<uint8_t>& v, uint32_t x) {
+    v.push_back(x >> 24); v.push_back(x >> 16); v.push_back(x >> 8); v.push_back(x);
+}
+
+static void writeChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> buf;
+    putU32(buf, (uint32_t)data.size());
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+    uint32_t crc = crc32(&buf[4], buf.size() - 4);
+    putU32(buf, crc);
+    fwrite(buf.data(), 1, buf.size(), f);
+}
+
+namespace hostPng {
+
+bool writeRgb565(const char* path, const uint16_t* pixels, int w, int h) {
+    initCrc();
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(sig, 1, sizeof(sig), f);
+
+    std::vector<uint8_t> ihdr;
+    putU32(ihdr, (uint32_t)w);
+    putU32(ihdr, (uint32_t)h);
+    ihdr.push_back(8);  // bit depth
+    ihdr.push_back(2);  // colour type RGB
+    ihdr.push_back(0);  // compression
+    ihdr.push_back(0);  // filter
+    ihdr.push_back(0);  // interlace
+    writeChunk(f, "IHDR", ihdr);
+
+    // Raw scanlines: filter byte 0 + RGB888
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)h * (w * 3 + 1));
+    for (int y = 0; y < h; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < w; x++) {
+            uint16_t c = pixels[y * w + x];
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            raw.push_back((uint8_t)((r << 3) | (r >> 2)));
+            raw.push_back((uint8_t)((g << 2) | (g >> 4)));
+            raw.push_back((uint8_t)((b << 3) | (b >> 2)));
+        }
+    }
+
+    std::vector<uint8_t> z = {0x78, 0x01};
+    size_t pos = 0;
+    do {
+        size_t len = raw.size() - pos;
+        if (len > 65535) len = 65535;
+        bool final = (pos + len == raw.size());
+        z.push_back(final ? 1 : 0);
+        z.push_back(len & 0xFF); z.push_back(len >> 8);
+        z.push_back(~len & 0xFF); z.push_back((~len >> 8) & 0xFF);
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) { a = (a + v) % 65521; b = (b + a) % 65521; }
+    putU32(z, (b << 16) | a);
+    writeChunk(f, "IDAT", z);
+    writeChunk(f, "IEND", {});
+
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
+
+}  // namespace hostPng
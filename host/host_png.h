@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+
+namespace hostPng {
+    // Write an RGB565 framebuffer as an uncompressed 8-bit RGB PNG
+    bool writeRgb565(const char* path, const uint16_t* pixels, int w, int h);
+}
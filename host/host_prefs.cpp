@@ -0,0 +1,80 @@
+#include <Preferences.h>
+#include <map>
+#include <vector>
+
+// One store for all namespaces, keyed "namespace/key"
+static std::map<std::string, std::vector<uint8_t>>& store() {
+    static std::map<std::string, std::vector<uint8_t>> s;
+    return s;
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    (void)readOnly;
+    _ns = name;
+    return true;
+}
+
+bool Preferences::clear() {
+    auto& s = store();
+    std::string prefix = _ns + "/";
+    for (auto it = s.begin(); it != s.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) it = s.erase(it);
+        else ++it;
+    }
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    return store().erase(fullKey(key)) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return store().count(fullKey(key)) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    const uint8_t* p = (const uint8_t*)value;
+    store()[fullKey(key)] = std::vector<uint8_t>(p, p + len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    auto it = store().find(fullKey(key));
+    return it == store().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    auto it = store().find(fullKey(key));
+    if (it == store().end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t v)   { return putBytes(key, &v, sizeof(v)); }
+size_t Preferences::putUShort(const char* key, uint16_t v) { return putBytes(key, &v, sizeof(v)); }
+size_t Preferences::putUInt(const char* key, uint32_t v)   { return putBytes(key, &v, sizeof(v)); }
+size_t Preferences::putBool(const char* key, bool v)       { return putBytes(key, &v, sizeof(v)); }
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return putBytes(key, value, strlen(value) + 1);
+}
+
+template <typename T>
+static T getValue(Preferences& p, const char* key, T def) {
+    T v;
+    return p.getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t d)   { return getValue(*this, key, d); }
+uint16_t Preferences::getUShort(const char* key, uint16_t d) { return getValue(*this, key, d); }
+uint32_t Preferences::getUInt(const char* key, uint32_t d)   { return getValue(*this, key, d); }
+bool Preferences::getBool(const char* key, bool d)           { return getValue(*this, key, d); }
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+    auto it = store().find(fullKey(key));
+    if (it == store().end() || maxLen == 0) return 0;
+    size_t n = it->second.size();
+    if (n > maxLen) return 0;
+    memcpy(value, it->second.data(), n);
+    return n;
+}
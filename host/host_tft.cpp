@@ -0,0 +1,248 @@
+#include <TFT_eSPI.h>
+#include <algorithm>
+
+// Nominal glyph cell per built-in font (width x height). Smooth fonts are
+// treated as a 26px font; see the note in TFT_eSPI.h.
+static void glyphCell(uint8_t font, bool smooth, int& w, int& h) {
+    if (smooth) { w = 13; h = 26; return; }
+    switch (font) {
+        case 1:  w = 6;  h = 8;  break;
+        case 2:  w = 8;  h = 16; break;
+        case 4:  w = 14; h = 26; break;
+        case 6:  w = 24; h = 48; break;
+        case 7:  w = 32; h = 48; break;
+        case 8:  w = 55; h = 75; break;
+        default: w = 6;  h = 8;  break;
+    }
+}
+
+// Count UTF-8 codepoints so multi-byte scripts take one cell per character
+static int glyphCount(const char* str) {
+    int n = 0;
+    for (const uint8_t* p = (const uint8_t*)str; *p; p++) {
+        if ((*p & 0xC0) != 0x80) n++;
+    }
+    return n;
+}
+
+bool TFT_eSPI::hostDmaSupported = true;
+uint32_t TFT_eSPI::hostCpuScale = 50;
+
+// Time to clock a transfer out over the modelled SPI bus
+static uint64_t transferUs(uint64_t bytes) {
+    return bytes * 8 * 1000000ULL / SPI_FREQUENCY;
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _width(w), _height(h) {
+    if (w > 0 && h > 0) _fb.assign((size_t)w * h, 0);
+}
+
+void TFT_eSPI::init() {
+    std::fill(_fb.begin(), _fb.end(), 0);
+    resetStats();
+}
+
+void TFT_eSPI::writeSpan(int32_t x, int32_t y, int32_t w, uint16_t color) {
+    uint16_t* dst = &_fb[(size_t)y * _width + x];
+    for (int32_t i = 0; i < w; i++) dst[i] = color;
+    _stats.pixelsDrawn += w;
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    writeSpan(x, y, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) w = _width - x;
+    if (y + h > _height) h = _height - y;
+    if (w <= 0 || h <= 0) return;
+    for (int32_t row = y; row < y + h; row++) {
+        writeSpan(x, row, w, (uint16_t)color);
+    }
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSPI::fillCircle(int32_t cx, int32_t cy, int32_t r, uint32_t color) {
+    for (int32_t dy = -r; dy <= r; dy++) {
+        int32_t dx = 0;
+        while ((dx + 1) * (dx + 1) + dy * dy <= r * r) dx++;
+        drawFastHLine(cx - dx, cy + dy, 2 * dx + 1, color);
+    }
+}
+
+int16_t TFT_eSPI::textWidth(const char* str, uint8_t font) {
+    int w, h;
+    glyphCell(font, fontLoaded, w, h);
+    return (int16_t)(glyphCount(str) * w);
+}
+
+int16_t TFT_eSPI::textWidth(const char* str) {
+    return textWidth(str, 1);
+}
+
+void TFT_eSPI::drawGlyphs(const char* str, int32_t x, int32_t y, uint8_t font) {
+    int cw, ch;
+    glyphCell(font, fontLoaded, cw, ch);
+    int32_t w = glyphCount(str) * cw;
+
+    switch (_datum) {
+        case TC_DATUM: case MC_DATUM: case BC_DATUM: x -= w / 2; break;
+        case TR_DATUM: case MR_DATUM: case BR_DATUM: x -= w; break;
+        default: break;
+    }
+    switch (_datum) {
+        case ML_DATUM: case MC_DATUM: case MR_DATUM: y -= ch / 2; break;
+        case BL_DATUM: case BC_DATUM: case BR_DATUM: y -= ch; break;
+        default: break;
+    }
+
+    // Background cell (built-in fonts fill it when bg != fg)
+    if (_textBg != _textFg && !fontLoaded) {
+        fillRect(x, y, w, ch, _textBg);
+    }
+
+    // One block per non-space character, inset so adjacent glyphs stay apart
+    const uint8_t* p = (const uint8_t*)str;
+    int32_t gx = x;
+    while (*p) {
+        uint8_t c = *p++;
+        while ((*p & 0xC0) == 0x80) p++;  // skip UTF-8 continuation bytes
+        if (c != ' ') {
+            int32_t gw = cw - 2;
+            int32_t gh = ch - ch / 4;
+            fillRect(gx + 1, y + ch / 8, gw, gh, _textFg);
+        }
+        gx += cw;
+    }
+}
+
+int16_t TFT_eSPI::drawString(const char* str, int32_t x, int32_t y, uint8_t font) {
+    drawGlyphs(str, x, y, font);
+    return textWidth(str, font);
+}
+
+int16_t TFT_eSPI::drawString(const char* str, int32_t x, int32_t y) {
+    return drawString(str, x, y, 1);
+}
+
+// CPU time as the firmware would see it: wall clock plus modelled SPI stalls
+uint64_t TFT_eSPI::cpuClockUs() const {
+    return (uint64_t)micros() * hostCpuScale + _stalledUs;
+}
+
+void TFT_eSPI::stall(uint64_t us) {
+    _stalledUs += us;
+    _stats.spiWaitUs += us;
+}
+
+void TFT_eSPI::waitBus() {
+    uint64_t now = cpuClockUs();
+    if (_busUntilUs > now) stall(_busUntilUs - now);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+    uint64_t bytes = (uint64_t)w * h * 2;
+    waitBus();
+    _stats.pushes++;
+    _stats.pushBytes += bytes;
+    stall(transferUs(bytes));  // Blocking: CPU waits for every byte
+    copyToPanel(x, y, w, h, data);
+}
+
+bool TFT_eSPI::initDMA(bool ctrl_cs) {
+    (void)ctrl_cs;
+    _dmaEnabled = hostDmaSupported;
+    return _dmaEnabled;
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data,
+                            uint16_t* buffer) {
+    if (!_dmaEnabled || w <= 0 || h <= 0) return;
+    (void)buffer;
+    uint64_t bytes = (uint64_t)w * h * 2;
+    waitBus();  // Like the real driver: finish the previous transfer first
+    _stats.pushes++;
+    _stats.dmaPushes++;
+    _stats.pushBytes += bytes;
+    _busUntilUs = cpuClockUs() + transferUs(bytes);
+    _dmaData = data;
+    copyToPanel(x, y, w, h, data);
+}
+
+void TFT_eSPI::dmaWait() {
+    waitBus();
+}
+
+bool TFT_eSPI::dmaBusy() {
+    return _busUntilUs > cpuClockUs();
+}
+
+void TFT_eSPI::copyToPanel(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+    for (int32_t row = 0; row < h; row++) {
+        int32_t sy = y + row;
+        if (sy < 0 || sy >= _height) continue;
+        for (int32_t col = 0; col < w; col++) {
+            int32_t sx = x + col;
+            if (sx < 0 || sx >= _width) continue;
+            uint16_t v = data[row * w + col];
+            _fb[(size_t)sy * _width + sx] = (uint16_t)((v >> 8) | (v << 8));
+        }
+    }
+}
+
+// -------------------------------------------------------
+TFT_eSprite::TFT_eSprite(TFT_eSPI* parent) : TFT_eSPI(0, 0), _parent(parent) {}
+
+TFT_eSprite::~TFT_eSprite() {
+    deleteSprite();
+}
+
+void* TFT_eSprite::createSprite(int16_t w, int16_t h) {
+    deleteSprite();
+    _img = (uint16_t*)calloc((size_t)w * h, sizeof(uint16_t));
+    if (_img) {
+        _width = w;
+        _height = h;
+    }
+    return _img;
+}
+
+void TFT_eSprite::deleteSprite() {
+    if (_img) {
+        free(_img);
+        _img = nullptr;
+    }
+    _width = 0;
+    _height = 0;
+}
+
+void TFT_eSprite::writeSpan(int32_t x, int32_t y, int32_t w, uint16_t color) {
+    // Sprite buffers hold RGB565 byte-swapped, ready for SPI
+    uint16_t swapped = (uint16_t)((color >> 8) | (color << 8));
+    uint16_t* dst = &_img[(size_t)y * _width + x];
+    for (int32_t i = 0; i < w; i++) dst[i] = swapped;
+    _parent->_stats.pixelsDrawn += w;
+    if (_img == _parent->_dmaData && _parent->dmaBusy()) _parent->_stats.dmaHazards++;
+}
+
+void TFT_eSprite::fillSprite(uint32_t color) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+    if (_img) _parent->pushImage(x, y, _width, _height, _img);
+}
@@ -0,0 +1,628 @@
+#include "asset_store.h"
+#include <Arduino.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <esp_partition.h>
+#include <cstdlib>
+#include <cstring>
+
+// Inventory of pack files on SPIFFS. All integers little-endian:
+//   header   "OINV", u8 format version, u8 reserved, u16 file count,
+//            u32 sequence number of the last install
+//   entries  sorted by name: AssetRecord, u32 install that last used it,
+//            u32 offset of its contents in the assets partition
+// Changes since the last save() are appended to the log as they happen, in
+// the same entry layout (install 0: the file was removed), so an install
+// cut short by a power loss still knows which files it completed.
+static const char* INVENTORY_PATH = "/inventory.idx";
+static const char* INVENTORY_TMP_PATH = "/inventory.idx.tmp";
+static const char* INVENTORY_LOG_PATH = "/inventory.log";
+static const uint8_t INVENTORY_FORMAT = 3;
+static const uint8_t ASSETS_FORMAT = 1;
+static const uint16_t GROW_STEP = 32;
+
+// Contents of every tracked file are on this partition, at the offsets the
+// inventory gives. Bytes no entry covers are free and reused by the next
+// write that fits. Flash only erases whole sectors, so a write erases just
+// the sectors no held file shares, and may only start or end in a shared
+// one where that is still erased.
+static const char* PARTITION_LABEL = "assets";
+static const uint32_t SECTOR = SPI_FLASH_SEC_SIZE;
+
+struct InventoryEntry {
+    AssetRecord rec;
+    uint32_t lastUsed;
+    uint32_t offset;
+};
+
+static InventoryEntry* _inv = nullptr;
+static uint16_t _invCount = 0;
+static uint16_t _invCap = 0;
+static uint32_t _seq = 0;
+
+static AssetRecord* _assets = nullptr;
+static uint16_t _assetCount = 0;
+
+static fs::File _log;  // Open for appending once the first change is logged
+
+static const esp_partition_t* _part = nullptr;  // Found on first use
+static const uint8_t* _map = nullptr;           // All of _part, mapped on first use
+static spi_flash_mmap_handle_t _mapHandle;
+
+// Room for one write: up to limit bytes from offset, of which the sectors
+// in [eraseFrom, eraseEnd) are its alone
+struct Placement {
+    uint32_t offset;
+    uint32_t limit;
+    uint32_t eraseFrom;
+    uint32_t eraseEnd;
+};
+
+// The one file being written
+static struct {
+    char name[sizeof(AssetRecord::name)];
+    Placement at;
+    uint32_t erasedTo;   // Sectors from at.eraseFrom up to here are erased
+    uint32_t written;
+    bool active;
+} _pending;
+
+// Resident lookup for reading, built from the inventory on first use: name
+// hashes into an open-addressed table of indices into _located
+struct LocatedAsset {
+    char name[sizeof(AssetRecord::name)];
+    AssetLocation at;
+};
+static const uint16_t SLOT_EMPTY = 0xFFFF;
+static LocatedAsset* _located = nullptr;
+static uint16_t _locatedCount = 0;
+static uint16_t* _slots = nullptr;
+static uint16_t _slotMask = 0;
+static bool _indexBuilt = false;
+
+static void dropIndex() {
+    free(_located);
+    free(_slots);
+    _located = nullptr;
+    _slots = nullptr;
+    _locatedCount = 0;
+    _slotMask = 0;
+    _indexBuilt = false;
+}
+
+static const esp_partition_t* partition() {
+    if (!_part) {
+        _part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         PARTITION_LABEL);
+        if (!_part) Serial.println("[assets] No assets partition");
+    }
+    return _part;
+}
+
+static const uint8_t* mapping() {
+    if (!_map && partition()) {
+        const void* p;
+        if (esp_partition_mmap(_part, 0, _part->size, SPI_FLASH_MMAP_DATA, &p, &_mapHandle) == ESP_OK) {
+            _map = (const uint8_t*)p;
+        } else {
+            Serial.println("[assets] Failed to map the assets partition");
+        }
+    }
+    return _map;
+}
+
+// Whether an entry's contents lie inside the partition (it may have shrunk)
+static bool fits(const InventoryEntry& e) {
+    uint32_t capacity = partition() ? _part->size : 0;
+    return e.offset <= capacity && e.rec.size <= capacity - e.offset;
+}
+
+static int compareRecords(const void* a, const void* b) {
+    return strncmp(((const AssetRecord*)a)->name, ((const AssetRecord*)b)->name,
+                   sizeof(AssetRecord::name));
+}
+
+// Index of name, or of where it would be inserted (found tells which)
+static uint16_t findEntry(const char* name, bool& found) {
+    uint16_t lo = 0, hi = _invCount;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        int c = strncmp(_inv[mid].rec.name, name, sizeof(AssetRecord::name));
+        if (c == 0) {
+            found = true;
+            return mid;
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    found = false;
+    return lo;
+}
+
+static bool readRecords(fs::File& f, void* out, size_t stride, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t* p = (uint8_t*)out + (size_t)i * stride;
+        if (f.read(p, stride) != stride) return false;
+        ((AssetRecord*)p)->name[sizeof(AssetRecord::name) - 1] = '\0';
+    }
+    return true;
+}
+
+// Entry for name, inserted if missing; nullptr if out of heap
+static InventoryEntry* upsert(const char* name) {
+    bool found;
+    uint16_t i = findEntry(name, found);
+    if (found) return &_inv[i];
+    if (_invCount == _invCap) {
+        uint16_t cap = _invCap + GROW_STEP;
+        InventoryEntry* grown = (InventoryEntry*)realloc(_inv, (size_t)cap * sizeof(InventoryEntry));
+        if (!grown) {
+            Serial.printf("[assets] No heap to track %s\n", name);
+            return nullptr;
+        }
+        _inv = grown;
+        _invCap = cap;
+    }
+    memmove(&_inv[i + 1], &_inv[i], (size_t)(_invCount - i) * sizeof(InventoryEntry));
+    _invCount++;
+    return &_inv[i];
+}
+
+static void removeAt(uint16_t i) {
+    memmove(&_inv[i], &_inv[i + 1], (size_t)(_invCount - i - 1) * sizeof(InventoryEntry));
+    _invCount--;
+}
+
+static void appendLog(const InventoryEntry& e) {
+    dropIndex();  // Rebuilt with the change on the next locate()
+    if (!_log) _log = SPIFFS.open(INVENTORY_LOG_PATH, "a");
+    if (!_log || _log.write((const uint8_t*)&e, sizeof(e)) != sizeof(e)) {
+        Serial.printf("[assets] Failed to log %s\n", e.rec.name);
+        return;
+    }
+    _log.flush();
+}
+
+static void logRemoval(const char* name) {
+    InventoryEntry e = {};
+    strlcpy(e.rec.name, name, sizeof(e.rec.name));
+    appendLog(e);
+}
+
+// Applies changes logged after the last save(); a torn last entry is ignored
+static uint16_t replayLog() {
+    fs::File f = SPIFFS.open(INVENTORY_LOG_PATH, "r");
+    if (!f) return 0;
+    uint16_t n = 0;
+    InventoryEntry e;
+    while (readRecords(f, &e, sizeof(e), 1)) {
+        bool found;
+        uint16_t i = findEntry(e.rec.name, found);
+        if (e.lastUsed == 0) {
+            if (found) removeAt(i);
+        } else if (InventoryEntry* slot = upsert(e.rec.name)) {
+            *slot = e;
+            if (e.lastUsed > _seq) _seq = e.lastUsed;
+        }
+        n++;
+    }
+    f.close();
+    return n;
+}
+
+static int compareOffsets(const void* a, const void* b) {
+    uint32_t x = _inv[*(const uint16_t*)a].offset, y = _inv[*(const uint16_t*)b].offset;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t roundUp(uint32_t x) {
+    return (x + SECTOR - 1) / SECTOR * SECTOR;
+}
+
+// Whether [from, to) still reads erased, so it can be written without an erase
+static bool erased(uint32_t from, uint32_t to) {
+    const uint8_t* m = mapping();
+    if (!m) return false;
+    for (uint32_t i = from; i < to; i++) {
+        if (m[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// Room for size bytes in the free range [start, end), which ends at the
+// next held file or, if last, at the end of the partition (where the write
+// may run on past size). A sector shared with the file before is only
+// written where still erased, else the write starts on the next sector.
+static bool placeIn(uint32_t start, uint32_t end, bool last, uint32_t size, Placement& p) {
+    if (size > end - start) return false;
+    p.eraseFrom = roundUp(start);
+    p.eraseEnd = last ? end : end / SECTOR * SECTOR;
+    uint32_t head = p.eraseFrom < end ? p.eraseFrom : end;
+    p.offset = start;
+    if (start < head && !erased(start, last || start + size > head ? head : start + size)) {
+        p.offset = head;
+        if (size > end - head) return false;
+    }
+    p.limit = last ? end - p.offset : size;
+    if (last) return true;
+    // ...and so is one shared with the file after
+    uint32_t tail = p.offset > p.eraseEnd ? p.offset : p.eraseEnd;
+    return p.offset + size <= tail || erased(tail, p.offset + size);
+}
+
+// The first gap between held contents that fits size bytes, else after the
+// last of them. size 0 (not known yet) goes at the end.
+static bool findSpace(uint32_t size, Placement& p) {
+    uint32_t capacity = partition() ? _part->size : 0;
+    uint16_t* order = (uint16_t*)malloc(((size_t)_invCount + 1) * sizeof(uint16_t));
+    uint32_t end = 0;
+    if (!order) {
+        for (uint16_t i = 0; i < _invCount; i++) {
+            if (_inv[i].offset + _inv[i].rec.size > end) end = _inv[i].offset + _inv[i].rec.size;
+        }
+        return end <= capacity && placeIn(end, capacity, true, size, p);
+    }
+    for (uint16_t i = 0; i < _invCount; i++) order[i] = i;
+    qsort(order, _invCount, sizeof(uint16_t), compareOffsets);
+    for (uint16_t k = 0; k < _invCount; k++) {
+        const InventoryEntry& e = _inv[order[k]];
+        if (size && e.offset > end && placeIn(end, e.offset, false, size, p)) {
+            free(order);
+            return true;
+        }
+        if (e.offset + e.rec.size > end) end = e.offset + e.rec.size;
+    }
+    free(order);
+    return end <= capacity && placeIn(end, capacity, true, size, p);
+}
+
+static uint32_t hashName(const char* name) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (uint8_t i = 0; i < sizeof(AssetRecord::name) && name[i]; i++) {
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Applies one snapshot (unique, so never replaced) or log entry to the index
+static void indexEntry(const InventoryEntry& e, bool fromLog) {
+    uint16_t i = _locatedCount;
+    if (fromLog) {
+        i = 0;
+        while (i < _locatedCount && strncmp(_located[i].name, e.rec.name, sizeof(e.rec.name)) != 0) i++;
+    }
+    if (e.lastUsed == 0 || !fits(e)) {
+        if (i < _locatedCount) _located[i] = _located[--_locatedCount];
+        return;
+    }
+    strlcpy(_located[i].name, e.rec.name, sizeof(_located[i].name));
+    _located[i].at.offset = e.offset;
+    _located[i].at.size = e.rec.size;
+    if (i == _locatedCount) _locatedCount++;
+}
+
+// Reads the inventory as SPIFFS holds it, log included, without touching
+// the tables an install may have loaded
+static void buildIndex() {
+    _indexBuilt = true;  // Also when there is none: a SPIFFS image from data/
+    fs::File f = SPIFFS.open(INVENTORY_PATH, "r");
+    if (!f) return;
+    uint8_t hdr[12];
+    bool ok = f.read(hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr, "OINV", 4) == 0 &&
+              hdr[4] == INVENTORY_FORMAT;
+    uint16_t listed = ok ? (hdr[6] | (hdr[7] << 8)) : 0;
+    fs::File log = SPIFFS.open(INVENTORY_LOG_PATH, "r");
+    uint32_t cap = listed + (log ? log.size() / sizeof(InventoryEntry) : 0);
+    if (ok && cap > 0 && cap < SLOT_EMPTY) {
+        _located = (LocatedAsset*)malloc(cap * sizeof(LocatedAsset));
+    }
+    if (_located) {
+        InventoryEntry e;
+        for (uint16_t i = 0; i < listed && readRecords(f, &e, sizeof(e), 1); i++) indexEntry(e, false);
+        while (log && readRecords(log, &e, sizeof(e), 1)) indexEntry(e, true);
+    }
+    f.close();
+    if (log) log.close();
+    if (!_locatedCount) return;
+
+    uint16_t slots = 16;
+    while (slots < _locatedCount * 2) slots <<= 1;
+    _slots = (uint16_t*)malloc(slots * sizeof(uint16_t));
+    if (!_slots) {
+        Serial.printf("[assets] No heap to index %u files\n", _locatedCount);
+        return;
+    }
+    memset(_slots, 0xFF, slots * sizeof(uint16_t));
+    _slotMask = slots - 1;
+    for (uint16_t i = 0; i < _locatedCount; i++) {
+        uint16_t h = hashName(_located[i].name) & _slotMask;
+        while (_slots[h] != SLOT_EMPTY) h = (h + 1) & _slotMask;
+        _slots[h] = i;
+    }
+    Serial.printf("[assets] Indexed %u files on the assets partition\n", _locatedCount);
+}
+
+namespace assetStore {
+
+bool load() {
+    release();
+    fs::File f = SPIFFS.open(INVENTORY_PATH, "r");
+    if (!f) return false;
+
+    uint8_t hdr[12];
+    bool ok = f.read(hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr, "OINV", 4) == 0 &&
+              hdr[4] == INVENTORY_FORMAT;
+    if (ok) {
+        _invCount = hdr[6] | (hdr[7] << 8);
+        _seq = hdr[8] | (hdr[9] << 8) | (hdr[10] << 16) | ((uint32_t)hdr[11] << 24);
+        _invCap = _invCount + GROW_STEP;
+        _inv = (InventoryEntry*)malloc((size_t)_invCap * sizeof(InventoryEntry));
+        ok = _inv && readRecords(f, _inv, sizeof(InventoryEntry), _invCount);
+    }
+    f.close();
+
+    if (!ok) {
+        Serial.println("[assets] Inventory unreadable");
+        release();
+        return false;
+    }
+    qsort(_inv, _invCount, sizeof(InventoryEntry), compareRecords);
+    uint16_t logged = replayLog();
+    for (uint16_t i = _invCount; i-- > 0;) {
+        if (fits(_inv[i])) continue;
+        logRemoval(_inv[i].rec.name);  // Past the end of a smaller partition
+        removeAt(i);
+    }
+    Serial.printf("[assets] Inventory: %u files, install %u, %u logged changes\n", _invCount, _seq,
+                  logged);
+    return true;
+}
+
+bool save() {
+    fs::File f = SPIFFS.open(INVENTORY_TMP_PATH, "w");
+    if (!f) return false;
+    uint8_t hdr[12] = {'O', 'I', 'N', 'V', INVENTORY_FORMAT, 0,
+                       (uint8_t)_invCount, (uint8_t)(_invCount >> 8),
+                       (uint8_t)_seq, (uint8_t)(_seq >> 8), (uint8_t)(_seq >> 16),
+                       (uint8_t)(_seq >> 24)};
+    bool ok = f.write(hdr, sizeof(hdr)) == sizeof(hdr);
+    size_t bytes = (size_t)_invCount * sizeof(InventoryEntry);
+    if (ok && bytes) ok = f.write((const uint8_t*)_inv, bytes) == bytes;
+    f.close();
+
+    if (ok) {
+        SPIFFS.remove(INVENTORY_PATH);
+        ok = SPIFFS.rename(INVENTORY_TMP_PATH, INVENTORY_PATH);
+    }
+    if (!ok) {
+        Serial.println("[assets] Failed to write inventory");
+        SPIFFS.remove(INVENTORY_TMP_PATH);
+        return false;
+    }
+    _log.close();
+    SPIFFS.remove(INVENTORY_LOG_PATH);  // All in the snapshot now
+    return true;
+}
+
+void release() {
+    abortWrite();
+    dropIndex();
+    if (_map) spi_flash_munmap(_mapHandle);
+    _map = nullptr;
+    _log.close();
+    free(_inv);
+    _inv = nullptr;
+    _invCount = _invCap = 0;
+    free(_assets);
+    _assets = nullptr;
+    _assetCount = 0;
+}
+
+void beginInstall() {
+    _seq++;
+}
+
+bool loadAssetList(const char* path) {
+    free(_assets);
+    _assets = nullptr;
+    _assetCount = 0;
+
+    fs::File f = SPIFFS.open(path, "r");
+    if (!f) return false;
+    uint8_t hdr[8];
+    bool ok = f.read(hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr, "OAST", 4) == 0 &&
+              hdr[4] == ASSETS_FORMAT;
+    uint16_t count = ok ? (hdr[6] | (hdr[7] << 8)) : 0;
+    if (ok && count) {
+        _assets = (AssetRecord*)malloc((size_t)count * sizeof(AssetRecord));
+        ok = _assets && readRecords(f, _assets, sizeof(AssetRecord), count);
+    }
+    f.close();
+
+    if (!ok) {
+        Serial.printf("[assets] %s unreadable\n", path);
+        free(_assets);
+        _assets = nullptr;
+        return false;
+    }
+    _assetCount = count;
+    qsort(_assets, _assetCount, sizeof(AssetRecord), compareRecords);  // Normally already sorted
+    return true;
+}
+
+const AssetRecord* asset(const char* name) {
+    if (!_assets) return nullptr;  // No list loaded yet
+    AssetRecord key = {};
+    strlcpy(key.name, name, sizeof(key.name));
+    return (const AssetRecord*)bsearch(&key, _assets, _assetCount, sizeof(AssetRecord),
+                                       compareRecords);
+}
+
+uint32_t listedBytes(const char* suffix) {
+    size_t sl = strlen(suffix);
+    uint32_t total = 0;
+    for (uint16_t i = 0; i < _assetCount; i++) {
+        size_t nl = strlen(_assets[i].name);
+        if (nl >= sl && strcmp(_assets[i].name + nl - sl, suffix) == 0) total += _assets[i].size;
+    }
+    return total;
+}
+
+bool has(const char* name) {
+    bool found;
+    uint16_t i = findEntry(name, found);
+    if (!found) return false;
+    // Unlisted or unhashed content can only be matched by name
+    const AssetRecord* a = asset(name);
+    return !a || a->crc == 0 || (a->crc == _inv[i].rec.crc && a->size == _inv[i].rec.size);
+}
+
+void markUsed(const char* name) {
+    bool found;
+    uint16_t i = findEntry(name, found);
+    if (found) _inv[i].lastUsed = _seq;
+}
+
+bool beginWrite(const char* name, uint32_t size) {
+    abortWrite();
+    forget(name);  // Its old contents' space can be reused right away
+    strlcpy(_pending.name, name, sizeof(_pending.name));
+    if (!findSpace(size, _pending.at)) {
+        Serial.printf("[assets] No room for %s (%u bytes)\n", name, size);
+        return false;
+    }
+    _pending.erasedTo = _pending.at.eraseFrom;
+    _pending.written = 0;
+    _pending.active = true;
+    return true;
+}
+
+bool write(const uint8_t* data, size_t n) {
+    if (!_pending.active) return false;
+    if (_pending.written + n > _pending.at.limit) {
+        Serial.printf("[assets] %s is larger than the %u bytes it was given\n", _pending.name,
+                      _pending.at.limit);
+        return false;
+    }
+    // Erase the sectors this chunk reaches as it gets to them, so the stall
+    // is spread over the download instead of taken up front
+    uint32_t at = _pending.at.offset + _pending.written;
+    uint32_t eraseTo = roundUp(at + n);
+    if (eraseTo > _pending.at.eraseEnd) eraseTo = _pending.at.eraseEnd;
+    for (; _pending.erasedTo < eraseTo; _pending.erasedTo += SECTOR) {
+        if (esp_partition_erase_range(_part, _pending.erasedTo, SECTOR) != ESP_OK) return false;
+    }
+    if (esp_partition_write(_part, at, data, n) != ESP_OK) return false;
+    _pending.written += n;
+    return true;
+}
+
+void commitWrite() {
+    if (!_pending.active) return;
+    _pending.active = false;
+    InventoryEntry* e = upsert(_pending.name);
+    if (!e) return;
+    const AssetRecord* a = asset(_pending.name);
+    memset(e, 0, sizeof(*e));
+    strlcpy(e->rec.name, _pending.name, sizeof(e->rec.name));
+    e->rec.size = _pending.written;
+    e->rec.crc = a ? a->crc : 0;
+    e->lastUsed = _seq;
+    e->offset = _pending.at.offset;
+    appendLog(*e);
+}
+
+void abortWrite() {
+    _pending.active = false;
+}
+
+size_t usedBytes() {
+    size_t used = 0;
+    for (uint16_t i = 0; i < _invCount; i++) used += _inv[i].rec.size;
+    return used;
+}
+
+size_t totalBytes() {
+    return partition() ? _part->size : 0;
+}
+
+void forget(const char* name) {
+    bool found;
+    uint16_t i = findEntry(name, found);
+    if (!found) return;
+    logRemoval(name);
+    removeAt(i);
+}
+
+bool collectGarbage(size_t targetBytes, uint8_t maxFiles) {
+    for (uint8_t n = 0; n < maxFiles; n++) {
+        if (usedBytes() <= targetBytes) return true;
+
+        // Least recently used file this install doesn't need
+        int victim = -1;
+        for (uint16_t i = 0; i < _invCount; i++) {
+            if (_inv[i].lastUsed < _seq && (victim < 0 || _inv[i].lastUsed < _inv[victim].lastUsed)) {
+                victim = i;
+            }
+        }
+        if (victim < 0) return true;  // Everything left is in use
+
+        logRemoval(_inv[victim].rec.name);  // Its space is free from here on
+        removeAt(victim);
+    }
+    return false;
+}
+
+uint16_t fileCount() { return _invCount; }
+
+bool locate(const char* name, AssetLocation& at) {
+    if (!_indexBuilt) buildIndex();
+    if (!_slots) return false;
+    for (uint16_t h = hashName(name) & _slotMask; _slots[h] != SLOT_EMPTY; h = (h + 1) & _slotMask) {
+        const LocatedAsset& l = _located[_slots[h]];
+        if (strncmp(l.name, name, sizeof(l.name)) == 0) {
+            at = l.at;
+            return true;
+        }
+    }
+    return false;
+}
+
+const uint8_t* contents(const AssetLocation& at) {
+    const uint8_t* m = mapping();
+    return m ? m + at.offset : nullptr;
+}
+
+}  // namespace assetStore
+
+bool AssetReader::open(const char* name) {
+    close();
+    AssetLocation at;
+    if (assetStore::locate(name, at)) {
+        _data = assetStore::contents(at);
+        _size = _data ? at.size : 0;
+        return _data != nullptr;
+    }
+    char path[48];
+    snprintf(path, sizeof(path), "/%s", name);
+    _file = SPIFFS.open(path, "r");
+    if (!_file) return false;
+    _size = _file.size();
+    return true;
+}
+
+size_t AssetReader::read(uint8_t* buf, size_t n) {
+    if (n > _size - _pos) n = _size - _pos;
+    if (n == 0) return 0;
+    size_t got = n;
+    if (_data) memcpy(buf, _data + _pos, n);
+    else got = _file.read(buf, n);
+    _pos += got;
+    return got;
+}
+
+void AssetReader::close() {
+    if (_file) _file.close();
+    _data = nullptr;
+    _size = _pos = 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <FS.h>
+#include <cstddef>
+#include <cstdint>
+
+// One pack file besides manifest.json and vocab.pack, identified by name and
+// content (an entry of assets.idx, see tools/build_pack.py)
+struct AssetRecord {
+    char name[16];   // SPIFFS file name without the leading '/', e.g. "1f34a.bin"
+    uint32_t size;
+    uint32_t crc;    // CRC-32 of the contents, 0 if unknown
+};
+
+// Where a held file's contents are in the assets partition
+struct AssetLocation {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Content-addressed view of the pack files on SPIFFS, used by packMgr so an
+// install only downloads what the device doesn't already hold. Files no
+// install needs any more stay as a cache until storage runs short.
+// The font and emoji are kept on the raw "assets" partition (see
+// partitions_ota.csv) rather than in a SPIFFS file each; the inventory on
+// SPIFFS says where each one is, and readers see them through one mapping
+// of the partition into the address space.
+// Tables live in RAM only between load() and release(); every committed
+// write, forget() and garbage-collected file is also logged to SPIFFS
+// straight away, so a power loss mid-install loses none of them.
+namespace assetStore {
+    // Device inventory (/inventory.idx)
+    bool load();                 // false if the device has none yet
+    bool save();                 // Snapshot, replacing the change log
+    void release();              // Free the inventory and asset list
+    void beginInstall();         // Files touched from now on are in use
+
+    // Asset list of the pack being installed (its assets.idx)
+    bool loadAssetList(const char* path);
+    const AssetRecord* asset(const char* name);   // nullptr if not listed
+    uint32_t listedBytes(const char* suffix);     // Total size of listed names ending in suffix
+
+    // Per file name
+    bool has(const char* name);        // Held, with the listed content if known
+    void markUsed(const char* name);   // Keep through this install's garbage collection
+    void forget(const char* name);     // Its space is free from now on
+
+    // Writing one file into the partition: in the first free gap that fits
+    // size (0 if not known yet: after the last file), erasing the flash
+    // sectors it gets to as it goes. Nothing is held until commitWrite(),
+    // which records it with its listed hash.
+    bool beginWrite(const char* name, uint32_t size);
+    bool write(const uint8_t* data, size_t n);  // false past size or on a write error
+    void commitWrite();
+    void abortWrite();                          // Its space stays free
+
+    // Drops files the current install doesn't use, least recently used
+    // first, until usedBytes() is at most targetBytes. Drops at most
+    // maxFiles per call; true when done.
+    bool collectGarbage(size_t targetBytes, uint8_t maxFiles);
+    size_t usedBytes();                // Bytes the held files take
+    size_t totalBytes();               // Size of the assets partition, 0 without one
+    uint16_t fileCount();
+
+    // Reading held files, through a resident index built from the inventory
+    // on first use (and again after any change): one hash probe per name
+    // instead of a SPIFFS path lookup. contents() points into the mapped
+    // partition, so reads go through the flash cache without a copy; the
+    // pointer stays valid until release().
+    bool locate(const char* name, AssetLocation& at);
+    const uint8_t* contents(const AssetLocation& at);  // nullptr if it can't be mapped
+}
+
+// Sequential reader of one pack file: its mapped bytes on the assets
+// partition, or else a standalone /<name> (a SPIFFS image uploaded from data/)
+class AssetReader {
+public:
+    bool open(const char* name);
+    size_t read(uint8_t* buf, size_t n);
+    const uint8_t* data() const { return _data; }  // All of it, nullptr for a standalone file
+    uint32_t size() const { return _size; }
+    void close();
+
+private:
+    fs::File _file;      // Standalone file only
+    const uint8_t* _data = nullptr;
+    uint32_t _size = 0;
+    uint32_t _pos = 0;
+};
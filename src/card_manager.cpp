@@ -15,6 +15,7 @@ void CardManager::init() {
 
 void CardManager::buildBatch() {
     _batchSize = settingsMgr.settings().wordsPerDay;
+    if (_batchSize > MAX_BATCH_WORDS) _batchSize = MAX_BATCH_WORDS;
     uint16_t startIdx = settingsMgr.settings().progressIndex;
 
     for (uint8_t i = 0; i < _batchSize; i++) {
@@ -23,6 +24,9 @@ void CardManager::buildBatch() {
 
     shuffleBatch();
     _currentPos = 0;
+
+    // Only today's words are read into RAM
+    vocabLoader::loadBatch(_dailyBatch, _batchSize);
 }
 
 void CardManager::shuffleBatch() {
@@ -60,6 +64,14 @@ void CardManager::nextCard() {
     _lastCardChangeMs = millis();  // Reset timer so it doesn't immediately advance again
 }
 
+void CardManager::prefetchNext() {
+    if (_prefetched || _batchSize < 2) return;
+    _prefetched = true;
+
+    uint8_t nextPos = (_currentPos + 1 < _batchSize) ? _currentPos + 1 : 0;
+    imageRenderer::prefetch(vocabLoader::batchWord(nextPos).emoji());
+}
+
 void CardManager::checkDayChange() {
     time_t now = time(nullptr);
 
@@ -88,7 +100,11 @@ void CardManager::checkDayChange() {
 }
 
 const WordEntry& CardManager::currentWord() const {
-    return WORD_LIST[_dailyBatch[_currentPos]];
+    return vocabLoader::batchWord(_currentPos);
+}
+
+uint16_t CardManager::currentWordIndex() const {
+    return _dailyBatch[_currentPos];
 }
 
 int CardManager::currentCardIndex() const {
@@ -102,8 +118,10 @@ int CardManager::totalCardsToday() const {
 void CardManager::loadCurrentImage() {
     const WordEntry& word = currentWord();
     // v2.0: load by emoji codepoint (e.g. "1f4a7") instead of word-based filename
-    imageRenderer::preloadImage(word.emoji);
-    Serial.printf("[card] Card %d/%d: %s (%s)\n",
+    imageRenderer::preloadImage(word.emoji());
+    _prefetched = false;
+    Serial.printf("[card] Card %d/%d: %s (%s), image cache %u hits / %u misses\n",
                   currentCardIndex(), totalCardsToday(),
-                  word.word, word.english);
+                  word.word(), word.english(),
+                  imageRenderer::cacheHits(), imageRenderer::cacheMisses());
 }
@@ -7,17 +7,20 @@ public:
     void init();
     bool update();              // Returns true if card changed (timer)
     void nextCard();            // Manually advance to next card
+    void prefetchNext();        // Decode the next card's image ahead of time (call when idle)
     void checkDayChange();
 
     const WordEntry& currentWord() const;
+    uint16_t currentWordIndex() const;  // Index in the pack
     int currentCardIndex() const;   // 1-based
     int totalCardsToday() const;
 
 private:
-    uint16_t _dailyBatch[25];
+    uint16_t _dailyBatch[MAX_BATCH_WORDS];
     uint8_t _batchSize = 0;
     uint8_t _currentPos = 0;
     uint32_t _lastCardChangeMs = 0;
+    bool _prefetched = false;   // Next card's image already requested
 
     void buildBatch();
     void loadCurrentImage();
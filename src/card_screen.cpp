@@ -1,12 +1,12 @@
 #include "card_screen.h"
 #include "display_manager.h"
+#include "dirty_region.h"
 #include "card_manager.h"
 #include "image_renderer.h"
 #include "vocab_loader.h"
 #include "settings_manager.h"
 #include "constants.h"
-#include <FS.h>
-#include <SPIFFS.h>
+#include "asset_store.h"
 
 // Dimmed accent color for glow effect (~40% brightness of CLR_ACCENT)
 static const uint16_t CLR_ACCENT_GLOW = 0x1909;
@@ -15,6 +15,14 @@ static const uint16_t CLR_ACCENT_GLOW = 0x1909;
 static uint8_t* fontData26 = nullptr;
 static bool smoothFontReady = false;
 
+// What the last frame showed, so render() only repaints strips that changed
+static int lastWordIndex = -1;
+static int lastCardIndex = -1;
+static int lastCardTotal = -1;
+static bool lastShowPhonetic = false;
+static bool lastSmoothFont = false;
+static char lastLangName[24] = "";
+
 // Helper: draw a filled rounded rect clipped to the current strip
 static void drawRoundedRect(TFT_eSprite& spr, int bx, int by, int bw, int bh,
                             int r, int stripY, uint16_t fillClr, uint16_t borderClr) {
@@ -76,10 +84,10 @@ static void drawRoundedRect(TFT_eSprite& spr, int bx, int by, int bw, int bh,
 // Load smooth font VLW data from SPIFFS into heap buffer
 static uint8_t* loadVlwFromSpiffs(const char* filename) {
     char path[48];
-    snprintf(path, sizeof(path), "/%s.vlw", filename);
+    snprintf(path, sizeof(path), "%s.vlw", filename);
 
-    fs::File f = SPIFFS.open(path, "r");
-    if (!f) {
+    AssetReader f;
+    if (!f.open(path)) {
         Serial.printf("[font] File not found: %s\n", path);
         return nullptr;
     }
@@ -119,7 +127,7 @@ void reloadFont() {
         smoothFontReady = false;
     }
     // Load the pack's font file
-    fontData26 = loadVlwFromSpiffs("font");  // loads /font.vlw
+    fontData26 = loadVlwFromSpiffs("font");  // loads font.vlw
     if (fontData26) {
         smoothFontReady = true;
         Serial.println("[font] Smooth font ready");
@@ -139,7 +147,7 @@ void freeFont() {
 
 void render() {
     const WordEntry& word = cardMgr.currentWord();
-    const bool showPhonetic = settingsMgr.settings().showPhonetic && strlen(word.phonetic) > 0;
+    const bool showPhonetic = settingsMgr.settings().showPhonetic && strlen(word.phonetic()) > 0;
 
     // Build the "Card X / Y" string once
     char counterBuf[24];
@@ -152,8 +160,35 @@ void render() {
     const int boxY   = WORD_BOX_Y - phoneticShift;
     const int boxH   = showPhonetic ? (WORD_BOX_H + 16) : WORD_BOX_H;  // 70 vs 54
 
+    const char* langName = vocabLoader::isLoaded()
+        ? vocabLoader::packInfo().languageDisplay : "No Pack";
+
+    // Work out which bands changed since the last frame
+    dirtyRegion.beginFrame(ScreenId::Cards);
+    if (showPhonetic != lastShowPhonetic || smoothFontReady != lastSmoothFont ||
+        strcmp(langName, lastLangName) != 0) {
+        // Layout shift or header change: everything moves
+        dirtyRegion.markAll();
+    } else {
+        if (cardMgr.currentWordIndex() != lastWordIndex) {
+            dirtyRegion.mark(imgY, IMG_DISPLAY_H);
+            dirtyRegion.mark(boxY, boxH);
+        }
+        if (cardMgr.currentCardIndex() != lastCardIndex ||
+            cardMgr.totalCardsToday() != lastCardTotal) {
+            dirtyRegion.mark(COUNTER_Y, 16);
+        }
+    }
+    lastWordIndex = cardMgr.currentWordIndex();
+    lastCardIndex = cardMgr.currentCardIndex();
+    lastCardTotal = cardMgr.totalCardsToday();
+    lastShowPhonetic = showPhonetic;
+    lastSmoothFont = smoothFontReady;
+    strlcpy(lastLangName, langName, sizeof(lastLangName));
+
     for (int strip = 0; strip < NUM_STRIPS; strip++) {
         int stripY = strip * STRIP_H;
+        if (!dirtyRegion.needsStrip(stripY)) continue;
         TFT_eSprite& spr = display.getStrip();
 
         // Ensure smooth font is NOT active for built-in font rendering
@@ -197,8 +232,6 @@ void render() {
             int y = textScreenY - stripY;
             if (y >= -16 && y < STRIP_H) {
                 char subtitle[32];
-                const char* langName = vocabLoader::isLoaded()
-                    ? vocabLoader::packInfo().languageDisplay : "No Pack";
                 snprintf(subtitle, sizeof(subtitle), "~ %s ~", langName);
                 spr.setTextDatum(TC_DATUM);
                 spr.setTextColor(CLR_TEXT_SECONDARY, CLR_HEADER_BG);
@@ -226,9 +259,9 @@ void render() {
                 spr.setTextDatum(TC_DATUM);
                 spr.setTextColor(CLR_TEXT_PRIMARY, CLR_WORD_BOX_BG);
                 if (smoothFontReady) {
-                    spr.drawString(word.word, SCREEN_W / 2, y);  // smooth font (no font number)
+                    spr.drawString(word.word(), SCREEN_W / 2, y);  // smooth font (no font number)
                 } else {
-                    spr.drawString(word.word, SCREEN_W / 2, y, 4);  // fallback to Font 4
+                    spr.drawString(word.word(), SCREEN_W / 2, y, 4);  // fallback to Font 4
                 }
                 if (spr.fontLoaded) spr.unloadFont();
             }
@@ -241,7 +274,7 @@ void render() {
             if (y >= -16 && y < STRIP_H) {
                 spr.setTextDatum(TC_DATUM);
                 spr.setTextColor(CLR_PHONETIC, CLR_WORD_BOX_BG);
-                spr.drawString(word.phonetic, SCREEN_W / 2, y, 2);
+                spr.drawString(word.phonetic(), SCREEN_W / 2, y, 2);
             }
         }
 
@@ -252,7 +285,7 @@ void render() {
             if (y >= -16 && y < STRIP_H) {
                 spr.setTextDatum(TC_DATUM);
                 spr.setTextColor(CLR_ENGLISH, CLR_WORD_BOX_BG);
-                spr.drawString(word.english, SCREEN_W / 2, y, 2);
+                spr.drawString(word.english(), SCREEN_W / 2, y, 2);
             }
         }
 
@@ -269,6 +302,8 @@ void render() {
         // Push the completed strip to the display
         display.pushStrip(stripY);
     }
+    display.waitStrips();
+    dirtyRegion.endFrame();
 }
 
 }  // namespace cardScreen
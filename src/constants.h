@@ -30,6 +30,7 @@ constexpr int IMG_DISPLAY_W = 120;
 constexpr int IMG_DISPLAY_H = 120;
 constexpr int IMG_X = (SCREEN_W - IMG_DISPLAY_W) / 2;   // 60
 constexpr int IMG_Y = (SCREEN_H - IMG_DISPLAY_H) / 2;   // 100 (centered vertically)
+constexpr int IMAGE_CACHE_SLOTS = 2;  // Decoded images kept (current + prefetched), 23 KB each
 
 // Word box (near bottom, above counter)
 constexpr int WORD_BOX_W = 210;
@@ -0,0 +1,44 @@
+#include "dirty_region.h"
+
+DirtyRegion dirtyRegion;
+
+static const uint32_t ALL_STRIPS = (NUM_STRIPS >= 32) ? 0xFFFFFFFFu : ((1u << NUM_STRIPS) - 1);
+
+void DirtyRegion::beginFrame(ScreenId screen) {
+    if (screen != _screen) {
+        _screen = screen;
+        markAll();
+    }
+    _framePushed = 0;
+}
+
+void DirtyRegion::endFrame() {
+    _mask = 0;
+    _lastFramePushed = _framePushed;
+}
+
+void DirtyRegion::markAll() {
+    _mask = ALL_STRIPS;
+}
+
+void DirtyRegion::mark(int y, int h) {
+    int y1 = y + h;  // exclusive
+    if (y < 0) y = 0;
+    if (y1 > SCREEN_H) y1 = SCREEN_H;
+    if (y >= y1) return;
+
+    for (int s = y / STRIP_H; s <= (y1 - 1) / STRIP_H; s++) {
+        _mask |= 1u << s;
+    }
+}
+
+bool DirtyRegion::needsStrip(int stripY) {
+    int s = stripY / STRIP_H;
+    if (s < 0 || s >= NUM_STRIPS || !(_mask & (1u << s))) {
+        _skipped++;
+        return false;
+    }
+    _pushed++;
+    _framePushed++;
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include "constants.h"
+
+// Which screen produced the last frame; switching screens repaints everything
+enum class ScreenId : uint8_t {
+    None,
+    Cards,
+    NoPack,
+    Settings
+};
+
+// Tracks which STRIP_H strips need repainting. Screens mark the Y ranges
+// whose content changed, render loops skip the strips that stayed clean.
+class DirtyRegion {
+public:
+    void beginFrame(ScreenId screen);     // Marks everything if the screen changed
+    void endFrame();                      // Clears marks once strips are pushed
+
+    void markAll();
+    void mark(int y, int h);              // Screen rows [y, y+h)
+    bool needsStrip(int stripY);          // False (and counted as skipped) if clean
+
+    uint32_t skippedStrips() const { return _skipped; }   // Since boot
+    uint32_t pushedStrips() const { return _pushed; }
+    uint8_t lastFrameStrips() const { return _lastFramePushed; }
+
+private:
+    static_assert(NUM_STRIPS <= 32, "dirty mask holds one bit per strip");
+
+    uint32_t _mask = 0xFFFFFFFF;
+    ScreenId _screen = ScreenId::None;
+    uint32_t _skipped = 0;
+    uint32_t _pushed = 0;
+    uint8_t _framePushed = 0;
+    uint8_t _lastFramePushed = 0;
+};
+
+extern DirtyRegion dirtyRegion;
@@ -13,9 +13,17 @@ void DisplayManager::init() {
     _tft.setRotation(0);  // Portrait mode
     _tft.fillScreen(CLR_BG_DARK);
 
-    // Create strip sprite for rendering
-    _strip.setColorDepth(16);
-    _strip.createSprite(SCREEN_W, STRIP_H);
+    // Create strip sprites for rendering. With DMA, strip N is transferred
+    // while strip N+1 is composed into the other buffer; without it (or if
+    // the second buffer can't be allocated) strips are pushed synchronously.
+    for (int i = 0; i < 2; i++) {
+        _strips[i].setColorDepth(16);
+        _strips[i].createSprite(SCREEN_W, STRIP_H);
+    }
+    _back = 0;
+    _dmaReady = _strips[1].created() && _tft.initDMA();
+    if (!_dmaReady) _strips[1].deleteSprite();
+    Serial.printf("[display] Strip pipeline: %s\n", _dmaReady ? "DMA double-buffered" : "synchronous");
 }
 
 void DisplayManager::setBrightness(uint8_t level) {
@@ -33,11 +41,32 @@ uint8_t DisplayManager::getBrightnessLevel() const {
 }
 
 TFT_eSprite& DisplayManager::getStrip() {
-    return _strip;
+    return _strips[_back];
 }
 
 void DisplayManager::pushStrip(int y) {
-    _strip.pushSprite(0, y);
+    TFT_eSprite& spr = _strips[_back];
+    if (!_dmaReady) {
+        spr.pushSprite(0, y);
+        return;
+    }
+
+    if (!_writing) {
+        _tft.startWrite();
+        _writing = true;
+    }
+    // Sprite data is already byte-swapped for the panel. pushImageDMA waits
+    // for the previous strip's transfer before queueing this one, so the
+    // buffer we switch to below is free to compose into.
+    _tft.pushImageDMA(0, y, SCREEN_W, STRIP_H, (uint16_t*)spr.getPointer());
+    _back ^= 1;
+}
+
+void DisplayManager::waitStrips() {
+    if (!_writing) return;
+    _tft.dmaWait();
+    _tft.endWrite();
+    _writing = false;
 }
 
 uint16_t DisplayManager::blendColor(uint16_t c1, uint16_t c2, float ratio) {
@@ -9,8 +9,10 @@ public:
     void setBrightnessLevel(uint8_t idx);    // 0=Low, 1=Med, 2=High
     uint8_t getBrightnessLevel() const;
 
-    TFT_eSprite& getStrip();
-    void pushStrip(int y);
+    TFT_eSprite& getStrip();     // Strip buffer to compose into next
+    void pushStrip(int y);       // Send the composed strip, then swap buffers
+    void waitStrips();           // Fence: returns once every pushed strip reached the panel
+    bool dmaActive() const { return _dmaReady; }
 
     TFT_eSPI& tft() { return _tft; }
 
@@ -19,7 +21,11 @@ public:
 
 private:
     TFT_eSPI _tft;
-    TFT_eSprite _strip = TFT_eSprite(&_tft);
+    // Two strip buffers: one is sent by DMA while the other is composed
+    TFT_eSprite _strips[2] = {TFT_eSprite(&_tft), TFT_eSprite(&_tft)};
+    uint8_t _back = 0;            // Index of the buffer being composed
+    bool _dmaReady = false;
+    bool _writing = false;        // SPI transaction held open across DMA strips
     uint8_t _brightnessIdx = DEFAULT_BRIGHTNESS;
 };
 
@@ -1,17 +1,96 @@
 #include "image_renderer.h"
+#include "asset_store.h"
 #include "display_manager.h"
 #include "constants.h"
-#include <FS.h>
-#include <SPIFFS.h>
-
-// Static heap-allocated buffer for decompressed RGB565 image (72x72 = 10368 bytes)
-static uint16_t* imageBuffer = nullptr;
-static bool imageLoaded = false;
+#include <Esp.h>
+
+// Each decoded image is kept in render-ready form: IMG_H source rows, each
+// already widened to IMG_DISPLAY_W columns (nearest-neighbour) and
+// byte-swapped into sprite order. 96 rows x 120 cols = 23040 bytes.
+static const size_t IMAGE_BUF_PIXELS = IMG_H * IMG_DISPLAY_W;
+static const size_t IMAGE_BUF_BYTES = IMAGE_BUF_PIXELS * sizeof(uint16_t);
+
+// Slots beyond the first are only allocated while this much contiguous heap
+// would remain afterwards
+static const uint32_t CACHE_HEAP_RESERVE = 48 * 1024;
+
+// Nearest-neighbour source column per display column, source row per display
+// row, and the first display column showing each source column (IMG_W: none)
+static uint8_t colMap[IMG_DISPLAY_W];
+static uint8_t rowMap[IMG_DISPLAY_H];
+static uint8_t firstCol[IMG_W + 1];
+static bool mapsReady = false;
+
+// Opaque (non-0x0000) runs of each pre-scaled row as [x0, len] in display
+// columns, so drawing copies whole runs instead of testing every pixel.
+// Typical emoji need ~110 spans (max ~340 in data/); rows that don't fit
+// in the pool fall back to the per-pixel test.
+struct Span { uint8_t x0; uint8_t len; };
+static const uint16_t MAX_SPANS = 512;
+static const uint8_t ROW_UNSPANNED = 0xFF;
+
+// One decoded image. Pixel buffers are heap-allocated on demand; the span
+// tables are small enough to stay static.
+struct ImageSlot {
+    uint16_t* pixels;            // IMAGE_BUF_PIXELS, nullptr until allocated
+    char name[16];               // Emoji file stem, "" if the slot holds nothing
+    uint32_t lastUsed;           // LRU tick
+    Span spans[MAX_SPANS];
+    uint16_t rowSpanStart[IMG_H];
+    uint8_t rowSpanCount[IMG_H];
+};
+
+// LRU cache of decoded images; `current` is the one drawPreloaded() draws
+// unless mapped.active
+static ImageSlot slots[IMAGE_CACHE_SLOTS];
+static int current = -1;
+static uint32_t useTick = 0;
+static uint32_t cacheHitCount = 0;
+static uint32_t cacheMissCount = 0;
 
 // ORLE header: 4 magic + 2 width + 2 height + 4 compressed size = 12 bytes (big-endian)
 static const uint32_t ORLE_MAGIC = 0x4F524C45;  // "ORLE"
 static const size_t ORLE_HEADER_SIZE = 12;
 
+// ORLE v2 ("ORL2", see tools/convert_emoji.py): the same header, then a
+// big-endian u16 per row giving where it starts in the payload. Each row is
+// coded on its own, exactly IMG_W pixels, so any row decodes without the
+// ones before it.
+static const uint32_t ORLE2_MAGIC = 0x4F524C32;  // "ORL2"
+static const size_t ORLE2_TABLE_SIZE = IMG_H * sizeof(uint16_t);
+static const size_t ORLE2_MAX_ROW = IMG_W * 3;   // All single-pixel literals
+
+// ORLE palette ("ORLP"): the same header, a big-endian u16 palette size (at
+// most 256) and that many big-endian RGB565 entries, then a row table and
+// rows as in v2. Records hold up to 64 pixels: bit 7 set for RGB565 values,
+// else one-byte palette indices; bit 6 set for a run of one value.
+static const uint32_t ORLEP_MAGIC = 0x4F524C50;  // "ORLP"
+static const uint16_t ORLEP_MAX_PALETTE = 256;
+
+// How the rows of a v2 or palette image are coded: palette is nullptr for
+// v2, else paletteSize big-endian RGB565 entries
+struct RowCoding {
+    const uint8_t* palette;
+    uint16_t paletteSize;
+};
+
+// v2 or palette image on the assets partition: validated once, then
+// drawPreloaded() decodes the rows each strip needs straight from flash,
+// with no buffer
+struct MappedImage {
+    RowCoding coding;
+    const uint8_t* table;
+    const uint8_t* payload;
+    uint32_t payloadSize;
+    char name[16];
+    bool active;
+};
+static MappedImage mapped;
+static MappedImage nextMapped;  // Validated by prefetch(), for preloadImage() to take over
+
+// The mapped image's palette in sprite byte order
+static uint16_t paletteLut[ORLEP_MAX_PALETTE];
+
 static uint16_t readU16BE(const uint8_t* p) {
     return (uint16_t)(p[0] << 8) | p[1];
 }
@@ -21,35 +100,96 @@ static uint32_t readU32BE(const uint8_t* p) {
            ((uint32_t)p[2] << 8)  | (uint32_t)p[3];
 }
 
-static bool rleDecompress(const uint8_t* compressed, uint32_t compressedSize,
-                          uint16_t* output, uint32_t pixelCount) {
-    uint32_t srcPos = 0;
+// A payload in a standalone file is streamed through this buffer, so
+// loading an image needs no heap beyond the slot buffers. One on the assets
+// partition is decoded where it is mapped, without a copy.
+static const size_t STREAM_BUF_SIZE = 256;
+static uint8_t streamBuf[STREAM_BUF_SIZE];
+
+// Reads the payload of an open ORLE file, which starts payloadAt bytes in
+// and has been read up to there: straight from its mapped bytes, or in
+// STREAM_BUF_SIZE chunks. Runs and literals may straddle a refill.
+class OrleReader {
+public:
+    OrleReader(AssetReader& file, uint32_t payloadAt, uint32_t payloadSize)
+        : _file(file), _unread(payloadSize) {
+        if (const uint8_t* data = file.data()) {
+            uint32_t held = file.size() - payloadAt;
+            _buf = data + payloadAt;
+            _len = (payloadSize < held) ? payloadSize : held;
+            _unread = payloadSize - _len;  // Past the end of the asset
+        }
+    }
+
+    // False at the end of the payload, or if the file ends before it
+    bool next(uint8_t& b) {
+        if (_pos == _len && !refill()) return false;
+        b = _buf[_pos++];
+        return true;
+    }
+
+    bool nextU16BE(uint16_t& v) {
+        uint8_t hi, lo;
+        if (!next(hi) || !next(lo)) return false;
+        v = (uint16_t)(hi << 8) | lo;
+        return true;
+    }
+
+    bool shortRead() const { return _shortRead; }
+    uint32_t consumed(uint32_t payloadSize) const { return payloadSize - _unread - (_len - _pos); }
+
+private:
+    bool refill() {
+        if (_unread == 0) return false;
+        size_t got = 0;
+        if (!_file.data()) {
+            size_t want = (_unread < STREAM_BUF_SIZE) ? _unread : STREAM_BUF_SIZE;
+            got = _file.read(streamBuf, want);
+        }
+        if (got == 0) {
+            _shortRead = true;
+            return false;
+        }
+        _unread -= got;
+        _buf = streamBuf;
+        _pos = 0;
+        _len = got;
+        return true;
+    }
+
+    AssetReader& _file;
+    const uint8_t* _buf = streamBuf;
+    uint32_t _unread;
+    size_t _pos = 0;
+    size_t _len = 0;
+    bool _shortRead = false;
+};
+
+static bool rleDecompress(OrleReader& in, uint16_t* output, uint32_t pixelCount) {
     uint32_t dstPos = 0;
+    uint8_t header;
 
-    while (srcPos < compressedSize && dstPos < pixelCount) {
-        uint8_t header = compressed[srcPos++];
+    while (dstPos < pixelCount && in.next(header)) {
+        uint16_t count = (header & 0x7F) + 1;
 
         if (header & 0x80) {
             // Run-length encoded: (count & 0x7F + 1) identical pixels
-            uint16_t count = (header & 0x7F) + 1;
-            if (srcPos + 2 > compressedSize) return false;
-            uint16_t pixel = readU16BE(&compressed[srcPos]);
-            srcPos += 2;
+            uint16_t pixel;
+            if (!in.nextU16BE(pixel)) return false;
 
             for (uint16_t i = 0; i < count && dstPos < pixelCount; i++) {
                 output[dstPos++] = pixel;
             }
         } else {
             // Literal run: (count + 1) literal pixels follow
-            uint16_t count = header + 1;
-            if (srcPos + (uint32_t)count * 2 > compressedSize) return false;
-
-            for (uint16_t i = 0; i < count && dstPos < pixelCount; i++) {
-                output[dstPos++] = readU16BE(&compressed[srcPos]);
-                srcPos += 2;
+            for (uint16_t i = 0; i < count; i++) {
+                uint16_t pixel;
+                if (!in.nextU16BE(pixel)) return false;
+                if (dstPos < pixelCount) output[dstPos++] = pixel;
             }
         }
     }
+    if (in.shortRead()) return false;
 
     // Fill remaining pixels with black (transparent) if decompression ended early
     while (dstPos < pixelCount) {
@@ -59,51 +199,145 @@ static bool rleDecompress(const uint8_t* compressed, uint32_t compressedSize,
     return true;
 }
 
-namespace imageRenderer {
+// Bytes of row r: [start, end) of the payload
+static void rowBounds(const uint8_t* table, uint32_t payloadSize, int r, uint32_t& start, uint32_t& end) {
+    start = readU16BE(table + r * 2);
+    end = (r + 1 < IMG_H) ? readU16BE(table + r * 2 + 2) : payloadSize;
+}
 
-void init() {
-    // Pre-allocate image buffer early before heap gets fragmented by JSON parsing
-    if (!imageBuffer) {
-        imageBuffer = (uint16_t*)malloc(IMG_W * IMG_H * sizeof(uint16_t));
-        if (imageBuffer) {
-            Serial.printf("[img] Pre-allocated image buffer (%u bytes)\n",
-                          (uint32_t)(IMG_W * IMG_H * sizeof(uint16_t)));
-        } else {
-            Serial.println("[img] WARNING: Failed to pre-allocate image buffer");
+// Rows must tile the payload from its start, in order
+static bool rowTableValid(const uint8_t* table, uint32_t payloadSize) {
+    uint32_t prevEnd = 0;
+    for (int r = 0; r < IMG_H; r++) {
+        uint32_t start, end;
+        rowBounds(table, payloadSize, r, start, end);
+        if (start != prevEnd || end < start || end - start > ORLE2_MAX_ROW) return false;
+        prevEnd = end;
+    }
+    return prevEnd == payloadSize;
+}
+
+// One record of a coded row: count pixels, a single stored value for a run
+struct RowRecord {
+    int count;
+    bool run;
+    bool indexed;           // Values are palette indices, else big-endian RGB565
+    const uint8_t* values;
+};
+
+// Reads the record at p[pos] of a row len bytes long; false if it runs past it
+static bool readRecord(const uint8_t* p, uint32_t len, uint32_t& pos, bool paletted, RowRecord& rec) {
+    if (pos >= len) return false;
+    uint8_t header = p[pos++];
+    rec.indexed = paletted && !(header & 0x80);
+    rec.run = header & (paletted ? 0x40 : 0x80);
+    rec.count = (header & (paletted ? 0x3F : 0x7F)) + 1;
+    uint32_t bytes = (rec.run ? 1 : rec.count) * (rec.indexed ? 1 : 2);
+    if (len - pos < bytes) return false;
+    rec.values = p + pos;
+    pos += bytes;
+    return true;
+}
+
+// Decodes one row of len bytes; false unless they code exactly IMG_W pixels,
+// all indices within the palette
+static bool decodeRow(const uint8_t* p, uint32_t len, const RowCoding& coding, uint16_t* out) {
+    uint32_t pos = 0;
+    int x = 0;
+    RowRecord rec;
+    while (x < IMG_W) {
+        if (!readRecord(p, len, pos, coding.palette != nullptr, rec) || rec.count > IMG_W - x) return false;
+        for (int i = 0; i < rec.count; i++) {
+            int at = rec.run ? 0 : i;
+            if (!rec.indexed) {
+                out[x++] = readU16BE(rec.values + at * 2);
+            } else if (rec.values[at] < coding.paletteSize) {
+                out[x++] = readU16BE(coding.palette + rec.values[at] * 2);
+            } else {
+                return false;
+            }
         }
     }
+    return pos == len;
 }
 
-void freeBuffer() {
-    if (imageBuffer) {
-        free(imageBuffer);
-        imageBuffer = nullptr;
-        imageLoaded = false;
-        Serial.println("[img] Freed image buffer");
+// Decodes every row of a v2 or palette payload in order
+static uint8_t rowBuf[ORLE2_MAX_ROW];
+static bool decodeRows(OrleReader& in, const RowCoding& coding, const uint8_t* table,
+                       uint32_t payloadSize, uint16_t* output) {
+    for (int r = 0; r < IMG_H; r++) {
+        uint32_t start, end;
+        rowBounds(table, payloadSize, r, start, end);
+        for (uint32_t i = 0; i < end - start; i++) {
+            if (!in.next(rowBuf[i])) return false;
+        }
+        if (!decodeRow(rowBuf, end - start, coding, output + r * IMG_W)) return false;
     }
+    return true;
 }
 
-bool preloadImage(const char* filename) {
-    imageLoaded = false;
+static void buildMaps() {
+    if (mapsReady) return;
+    for (int c = 0; c < IMG_DISPLAY_W; c++) colMap[c] = c * IMG_W / IMG_DISPLAY_W;
+    for (int r = 0; r < IMG_DISPLAY_H; r++) rowMap[r] = r * IMG_H / IMG_DISPLAY_H;
+    for (int sx = 0, c = 0; sx <= IMG_W; sx++) {
+        while (c < IMG_DISPLAY_W && colMap[c] < sx) c++;
+        firstCol[sx] = c;
+    }
+    mapsReady = true;
+}
 
-    // Allocate image buffer if not already done
-    if (!imageBuffer) {
-        imageBuffer = (uint16_t*)malloc(IMG_W * IMG_H * sizeof(uint16_t));
-        if (!imageBuffer) {
-            Serial.println("[img] Failed to allocate image buffer");
-            return false;
+// Record the opaque spans of one pre-scaled row
+static void buildRowSpans(ImageSlot& slot, int r, const uint16_t* row, uint16_t& used) {
+    uint16_t start = used;
+    int c = 0;
+    while (c < IMG_DISPLAY_W) {
+        while (c < IMG_DISPLAY_W && row[c] == 0) c++;
+        if (c == IMG_DISPLAY_W) break;
+        int x0 = c;
+        while (c < IMG_DISPLAY_W && row[c] != 0) c++;
+        if (used == MAX_SPANS) {
+            used = start;  // Give the pool back; draw this row per pixel
+            slot.rowSpanCount[r] = ROW_UNSPANNED;
+            return;
+        }
+        slot.spans[used].x0 = (uint8_t)x0;
+        slot.spans[used].len = (uint8_t)(c - x0);
+        used++;
+    }
+    slot.rowSpanStart[r] = start;
+    slot.rowSpanCount[r] = (uint8_t)(used - start);
+}
+
+// Widen decoded IMG_W x IMG_H pixels (stored at the tail of the slot buffer)
+// into IMG_DISPLAY_W-wide sprite-order rows from the top, and index their
+// opaque spans. Row r ends at or before the start of source row r+1, so
+// nothing is overwritten before it is read; the row copy covers the overlap
+// within the last few rows.
+static void prescaleRows(ImageSlot& slot, const uint16_t* decoded) {
+    uint16_t row[IMG_W];
+    uint16_t spansUsed = 0;
+    for (int r = 0; r < IMG_H; r++) {
+        memcpy(row, decoded + r * IMG_W, sizeof(row));
+        uint16_t* dst = slot.pixels + r * IMG_DISPLAY_W;
+        for (int c = 0; c < IMG_DISPLAY_W; c++) {
+            uint16_t px = row[colMap[c]];
+            dst[c] = (uint16_t)((px >> 8) | (px << 8));
         }
+        buildRowSpans(slot, r, dst, spansUsed);
     }
+}
 
-    // Clear buffer to black (transparent)
-    memset(imageBuffer, 0, IMG_W * IMG_H * sizeof(uint16_t));
+// Load + decompress {filename}.bin into a slot whose buffer is allocated
+static bool decodeInto(ImageSlot& slot, const char* filename) {
+    slot.name[0] = '\0';
 
-    // Build path: /{filename}.bin
+    // Asset name: {filename}.bin, on the assets partition or a file of its own
     char path[64];
-    snprintf(path, sizeof(path), "/%s.bin", filename);
+    snprintf(path, sizeof(path), "%s.bin", filename);
 
-    fs::File f = SPIFFS.open(path, "r");
-    if (!f) {
+    AssetReader f;
+    if (!f.open(path)) {
         Serial.printf("[img] File not found: %s\n", path);
         return false;
     }
@@ -120,8 +354,10 @@ bool preloadImage(const char* filename) {
     uint16_t width = readU16BE(&headerBuf[4]);
     uint16_t height = readU16BE(&headerBuf[6]);
     uint32_t compressedSize = readU32BE(&headerBuf[8]);
+    bool paletted = (magic == ORLEP_MAGIC);
+    bool rowCoded = paletted || magic == ORLE2_MAGIC;
 
-    if (magic != ORLE_MAGIC) {
+    if (magic != ORLE_MAGIC && !rowCoded) {
         Serial.printf("[img] Invalid magic: 0x%08X\n", magic);
         f.close();
         return false;
@@ -134,74 +370,348 @@ bool preloadImage(const char* filename) {
         return false;
     }
 
-    // Allocate temporary buffer for compressed data
-    uint8_t* compressed = (uint8_t*)malloc(compressedSize);
-    if (!compressed) {
-        Serial.printf("[img] Failed to allocate %u bytes for compressed data\n", compressedSize);
-        f.close();
-        return false;
+    static uint8_t palette[ORLEP_MAX_PALETTE * 2];
+    RowCoding coding = {nullptr, 0};
+    uint32_t payloadAt = ORLE_HEADER_SIZE;
+    if (paletted) {
+        uint8_t count[2];
+        bool ok = f.read(count, sizeof(count)) == sizeof(count);
+        coding = {palette, ok ? readU16BE(count) : (uint16_t)0};
+        size_t bytes = coding.paletteSize * 2u;
+        if (!ok || coding.paletteSize > ORLEP_MAX_PALETTE || f.read(palette, bytes) != bytes) {
+            Serial.println("[img] Invalid ORLE palette");
+            f.close();
+            return false;
+        }
+        payloadAt += sizeof(count) + bytes;
     }
 
-    // Read compressed data
-    size_t bytesRead = f.read(compressed, compressedSize);
-    f.close();
+    uint8_t table[ORLE2_TABLE_SIZE];
+    if (rowCoded) {
+        if (f.read(table, sizeof(table)) != sizeof(table) || !rowTableValid(table, compressedSize)) {
+            Serial.println("[img] Invalid ORLE row table");
+            f.close();
+            return false;
+        }
+        payloadAt += ORLE2_TABLE_SIZE;
+    }
 
-    if (bytesRead != compressedSize) {
-        Serial.printf("[img] Short read: %u of %u bytes\n", (uint32_t)bytesRead, compressedSize);
-        free(compressed);
+    // The header has been read, so the file holds at least payloadAt bytes
+    if (compressedSize > f.size() - payloadAt) {
+        Serial.printf("[img] Truncated: %u bytes compressed, %u in file\n",
+                      compressedSize, (uint32_t)(f.size() - payloadAt));
+        f.close();
         return false;
     }
 
-    // RLE decompress into image buffer
-    bool ok = rleDecompress(compressed, compressedSize, imageBuffer, IMG_W * IMG_H);
-    free(compressed);
+    // RLE decompress straight from the file into the tail of the slot
+    // buffer, then widen in place
+    uint16_t* decoded = slot.pixels + (IMAGE_BUF_PIXELS - IMG_W * IMG_H);
+    OrleReader reader(f, payloadAt, compressedSize);
+    bool ok = rowCoded ? decodeRows(reader, coding, table, compressedSize, decoded)
+                       : rleDecompress(reader, decoded, IMG_W * IMG_H);
+    f.close();
 
     if (!ok) {
-        Serial.println("[img] RLE decompression failed");
+        if (reader.shortRead()) {
+            Serial.printf("[img] Short read: %u of %u bytes\n",
+                          reader.consumed(compressedSize), compressedSize);
+        } else {
+            Serial.println("[img] RLE decompression failed");
+        }
         return false;
     }
+    prescaleRows(slot, decoded);
 
-    imageLoaded = true;
+    // Names that don't fit are decoded but never matched by findSlot()
+    if (strlen(filename) < sizeof(slot.name)) {
+        strlcpy(slot.name, filename, sizeof(slot.name));
+    }
     Serial.printf("[img] Loaded %s (%ux%u, %u bytes compressed)\n",
                   path, width, height, compressedSize);
     return true;
 }
 
+// {filename}.bin as a mapped image, if it is ORLE v2 or palette on the assets
+// partition and every row decodes. Anything else goes through decodeInto().
+static bool openMapped(const char* filename, MappedImage& m) {
+    char path[64];
+    snprintf(path, sizeof(path), "%s.bin", filename);
+    AssetReader f;
+    if (!f.open(path) || !f.data()) return false;
+    const uint8_t* data = f.data();
+    uint32_t size = f.size();
+    f.close();
+
+    if (size < ORLE_HEADER_SIZE + 2) return false;
+    uint32_t magic = readU32BE(data);
+    if ((magic != ORLE2_MAGIC && magic != ORLEP_MAGIC) ||
+        readU16BE(data + 4) != IMG_W || readU16BE(data + 6) != IMG_H) {
+        return false;
+    }
+    uint32_t at = ORLE_HEADER_SIZE;
+    m.coding = {nullptr, 0};
+    if (magic == ORLEP_MAGIC) {
+        m.coding = {data + at + 2, readU16BE(data + at)};
+        at += 2 + m.coding.paletteSize * 2u;
+        if (m.coding.paletteSize > ORLEP_MAX_PALETTE || at > size) return false;
+    }
+    if (size - at < ORLE2_TABLE_SIZE) return false;
+    m.table = data + at;
+    m.payload = m.table + ORLE2_TABLE_SIZE;
+    m.payloadSize = readU32BE(data + 8);
+    if (m.payloadSize > size - at - ORLE2_TABLE_SIZE || !rowTableValid(m.table, m.payloadSize)) {
+        return false;
+    }
+    uint16_t row[IMG_W];
+    for (int r = 0; r < IMG_H; r++) {
+        uint32_t start, end;
+        rowBounds(m.table, m.payloadSize, r, start, end);
+        if (!decodeRow(m.payload + start, end - start, m.coding, row)) return false;
+    }
+    // Names that don't fit are drawn but never matched again
+    strlcpy(m.name, strlen(filename) < sizeof(m.name) ? filename : "", sizeof(m.name));
+    m.active = true;
+    return true;
+}
+
+// Sets the display columns source columns [sx0, sx1) widen to, within
+// colStart to colEnd
+static inline void fillColumns(uint16_t* dst, int sx0, int sx1, int colStart, int colEnd, uint16_t pixel) {
+    int c0 = firstCol[sx0] > colStart ? firstCol[sx0] : colStart;
+    int c1 = firstCol[sx1] < colEnd ? firstCol[sx1] : colEnd;
+    for (int c = c0; c < c1; c++) dst[c] = pixel;
+}
+
+// Decodes row r of the mapped image straight into dst, display columns
+// colStart to colEnd: each run fills the columns it widens to, transparent
+// ones are skipped. Pixels go out in sprite byte order, which is the
+// big-endian order they are stored in; indices go through paletteLut.
+static void drawMappedRow(int r, uint16_t* dst, int colStart, int colEnd) {
+    uint32_t start, end;
+    rowBounds(mapped.table, mapped.payloadSize, r, start, end);
+    // Checked by openMapped(); the bounds only guard against flash changing since
+    if (end < start || end > mapped.payloadSize) return;
+    const uint8_t* p = mapped.payload + start;
+    uint32_t len = end - start;
+    uint32_t pos = 0;
+    int sx = 0;
+    RowRecord rec;
+    while (sx < IMG_W && readRecord(p, len, pos, mapped.coding.palette != nullptr, rec)) {
+        if (rec.count > IMG_W - sx) return;
+        if (rec.run) {
+            uint16_t pixel = rec.indexed ? paletteLut[rec.values[0]]
+                                         : (uint16_t)(rec.values[0] | (rec.values[1] << 8));
+            if (pixel) fillColumns(dst, sx, sx + rec.count, colStart, colEnd, pixel);
+            sx += rec.count;
+        } else if (rec.indexed) {
+            for (int i = 0; i < rec.count; i++, sx++) {
+                uint16_t pixel = paletteLut[rec.values[i]];
+                if (pixel) fillColumns(dst, sx, sx + 1, colStart, colEnd, pixel);
+            }
+        } else {
+            for (int i = 0; i < rec.count; i++, sx++) {
+                uint16_t pixel = (uint16_t)(rec.values[i * 2] | (rec.values[i * 2 + 1] << 8));
+                if (pixel) fillColumns(dst, sx, sx + 1, colStart, colEnd, pixel);
+            }
+        }
+    }
+}
+
+static int findSlot(const char* filename) {
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) {
+        if (slots[i].pixels && slots[i].name[0] && strcmp(slots[i].name, filename) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool allocSlot(ImageSlot& slot) {
+    bool first = true;
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) {
+        if (slots[i].pixels) first = false;
+    }
+    // The first buffer is required; further ones are only a cache
+    if (!first && ESP.getMaxAllocHeap() < IMAGE_BUF_BYTES + CACHE_HEAP_RESERVE) return false;
+
+    slot.pixels = (uint16_t*)malloc(IMAGE_BUF_BYTES);
+    slot.name[0] = '\0';
+    slot.lastUsed = 0;
+    return slot.pixels != nullptr;
+}
+
+// Slot to decode a new image into: the least recently used allocated slot
+// other than the current one, else a newly allocated one if the heap
+// allows. With allowCurrent, the current slot is reused as a last resort.
+static int victimSlot(bool allowCurrent) {
+    int best = -1;
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) {
+        if (i == current || !slots[i].pixels) continue;
+        if (best < 0 || slots[i].lastUsed < slots[best].lastUsed) best = i;
+    }
+    if (best >= 0) return best;
+
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) {
+        if (i != current && !slots[i].pixels && allocSlot(slots[i])) return i;
+    }
+    return (allowCurrent && current >= 0) ? current : -1;
+}
+
+namespace imageRenderer {
+
+void init() {
+    // Image buffers are only needed for v1 images, or ones not on the
+    // assets partition: they are allocated by the first such decode
+    buildMaps();
+}
+
+void freeBuffer() {
+    bool freed = false;
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) {
+        if (!slots[i].pixels) continue;
+        free(slots[i].pixels);
+        slots[i].pixels = nullptr;
+        slots[i].name[0] = '\0';
+        freed = true;
+    }
+    current = -1;
+    mapped.active = false;
+    nextMapped.active = false;
+    if (freed) Serial.println("[img] Freed image buffers");
+}
+
+void invalidateCache() {
+    for (int i = 0; i < IMAGE_CACHE_SLOTS; i++) slots[i].name[0] = '\0';
+    current = -1;
+    mapped.active = false;
+    nextMapped.active = false;
+}
+
+bool preloadImage(const char* filename) {
+    buildMaps();
+
+    if (mapped.active && strcmp(mapped.name, filename) == 0) {
+        cacheHitCount++;
+        return true;
+    }
+    int i = findSlot(filename);
+    if (i >= 0) {
+        cacheHitCount++;
+        slots[i].lastUsed = ++useTick;
+        current = i;
+        mapped.active = false;
+        return true;
+    }
+    // A mapped image needs no decode either, nor validating again if prefetched
+    MappedImage m;
+    bool prefetched = nextMapped.active && strcmp(nextMapped.name, filename) == 0;
+    if (prefetched) {
+        m = nextMapped;
+        nextMapped.active = false;
+    }
+    if (prefetched || openMapped(filename, m)) {
+        cacheHitCount++;
+        mapped = m;
+        for (uint16_t j = 0; j < m.coding.paletteSize; j++) {
+            const uint8_t* entry = m.coding.palette + j * 2;
+            paletteLut[j] = (uint16_t)(entry[0] | (entry[1] << 8));
+        }
+        current = -1;
+        return true;
+    }
+    cacheMissCount++;
+    mapped.active = false;
+
+    i = victimSlot(true);
+    current = -1;
+    if (i < 0) {
+        Serial.println("[img] Failed to allocate image buffer");
+        return false;
+    }
+    if (!decodeInto(slots[i], filename)) return false;
+
+    slots[i].lastUsed = ++useTick;
+    current = i;
+    return true;
+}
+
+bool prefetch(const char* filename) {
+    buildMaps();
+    if (findSlot(filename) >= 0) return true;
+    if (mapped.active && strcmp(mapped.name, filename) == 0) return true;
+    if (nextMapped.active && strcmp(nextMapped.name, filename) == 0) return true;
+    MappedImage m;
+    if (openMapped(filename, m)) {
+        nextMapped = m;
+        return true;
+    }
+
+    int i = victimSlot(false);
+    if (i < 0) return false;
+    if (!decodeInto(slots[i], filename)) return false;
+
+    slots[i].lastUsed = ++useTick;
+    return true;
+}
+
+uint32_t cacheHits() {
+    return cacheHitCount;
+}
+
+uint32_t cacheMisses() {
+    return cacheMissCount;
+}
+
 void drawPreloaded(int x, int y, int stripY) {
-    if (!imageLoaded || !imageBuffer) return;
+    if (current < 0 && !mapped.active) return;
 
     TFT_eSprite& strip = display.getStrip();
-
-    // Display size from constants (e.g. 120x120, scaled from 72x72 source)
-    int displayW = IMG_DISPLAY_W;
-    int displayH = IMG_DISPLAY_H;
+    uint16_t* spriteBuf = (uint16_t*)strip.getPointer();
+    if (!spriteBuf) return;
 
     // Determine which display rows overlap with the current strip
     int dispRowStart = stripY - y;
     int dispRowEnd = dispRowStart + STRIP_H;
 
     if (dispRowStart < 0) dispRowStart = 0;
-    if (dispRowEnd > displayH) dispRowEnd = displayH;
-    if (dispRowStart >= dispRowEnd || dispRowStart >= displayH || dispRowEnd <= 0) return;
+    if (dispRowEnd > IMG_DISPLAY_H) dispRowEnd = IMG_DISPLAY_H;
+    if (dispRowStart >= dispRowEnd) return;
+
+    // Clip columns to the strip width
+    int colStart = (x < 0) ? -x : 0;
+    int colEnd = (x + IMG_DISPLAY_W > SCREEN_W) ? SCREEN_W - x : IMG_DISPLAY_W;
+    if (colStart >= colEnd) return;
 
     for (int dispRow = dispRowStart; dispRow < dispRowEnd; dispRow++) {
-        int screenY = y + dispRow;
-        int spriteRow = screenY - stripY;
-        if (spriteRow < 0 || spriteRow >= STRIP_H) continue;
-
-        // Map display row back to source image row (nearest-neighbor)
-        int imgRow = dispRow * IMG_H / displayH;
-        if (imgRow >= IMG_H) continue;
-
-        const uint16_t* srcRow = &imageBuffer[imgRow * IMG_W];
-
-        // Draw each display column, mapping back to source column
-        for (int dispCol = 0; dispCol < displayW; dispCol++) {
-            int imgCol = dispCol * IMG_W / displayW;
-            uint16_t pixel = srcRow[imgCol];
-            if (pixel != 0x0000) {  // Skip transparent
-                strip.drawPixel(x + dispCol, spriteRow, pixel);
+        int spriteRow = y + dispRow - stripY;
+        int imgRow = rowMap[dispRow];
+        uint16_t* dst = &spriteBuf[spriteRow * SCREEN_W + x];
+        if (mapped.active) {
+            drawMappedRow(imgRow, dst, colStart, colEnd);
+            continue;
+        }
+
+        // Rows are pre-scaled and in sprite byte order: copy the opaque
+        // spans straight into the sprite buffer, leaving transparent gaps
+        const ImageSlot& slot = slots[current];
+        const uint16_t* src = &slot.pixels[imgRow * IMG_DISPLAY_W];
+
+        if (slot.rowSpanCount[imgRow] == ROW_UNSPANNED) {
+            for (int c = colStart; c < colEnd; c++) {
+                uint16_t pixel = src[c];
+                if (pixel) dst[c] = pixel;
             }
+            continue;
+        }
+
+        const Span* span = &slot.spans[slot.rowSpanStart[imgRow]];
+        for (uint8_t i = 0; i < slot.rowSpanCount[imgRow]; i++, span++) {
+            int c0 = span->x0;
+            int c1 = c0 + span->len;
+            if (c0 < colStart) c0 = colStart;
+            if (c1 > colEnd) c1 = colEnd;
+            if (c0 < c1) memcpy(&dst[c0], &src[c0], (c1 - c0) * sizeof(uint16_t));
         }
     }
 }
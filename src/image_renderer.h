@@ -2,8 +2,13 @@
 #include <cstdint>
 
 namespace imageRenderer {
-    void init();                              // Pre-allocate image buffer (call early before heap fragments)
-    void freeBuffer();                        // Free image buffer to reclaim heap (e.g. before TLS)
-    bool preloadImage(const char* filename);  // Load + decompress from SPIFFS into RAM buffer
+    void init();                              // Build scaling tables; buffers come with the first v1 decode
+    void freeBuffer();                        // Free image buffers to reclaim heap (e.g. before TLS)
+    void invalidateCache();                   // Forget images (e.g. after image files changed or assetStore::release())
+    bool preloadImage(const char* filename);  // Make image current: mapped v2/palette, from the cache, else decompress
+    bool prefetch(const char* filename);      // Decode into a spare cache slot (validate if mapped) without changing the current image
     void drawPreloaded(int x, int y, int stripY);  // Draw relevant rows into current strip
+
+    uint32_t cacheHits();                     // preloadImage() calls served from the cache or mapped
+    uint32_t cacheMisses();                   // ...and those that had to decode
 }
@@ -3,6 +3,7 @@
 #include <Esp.h>
 #include "constants.h"
 #include "display_manager.h"
+#include "dirty_region.h"
 #include "splash_screen.h"
 #include "touch_handler.h"
 #include "settings_manager.h"
@@ -54,7 +55,7 @@ void setup() {
     Serial.printf("[boot] Free heap: %u\n", ESP.getFreeHeap());
 
     if (hasManifest) {
-        // Pre-allocate image buffer before JSON parsing fragments the heap
+        // Image scaling tables; v1 images allocate their buffer on first draw
         imageRenderer::init();
 
         bool loaded = vocabLoader::load();
@@ -69,9 +70,16 @@ void setup() {
         } else {
             packInstalled = false;
             appState = AppState::NoPack;
-            Serial.println("[boot] Manifest exists but vocab load failed, removing corrupt file");
+            Serial.println("[boot] Manifest exists but vocab load failed, removing corrupt files");
             SPIFFS.remove("/manifest.json");
+            SPIFFS.remove("/vocab.pack");
         }
+    } else if (packMgr::hasPendingInstall()) {
+        // Rebooted mid-install: finish it instead of asking for a pack again
+        packInstalled = false;
+        settingsUI.resumeDownload();
+        appState = AppState::Settings;
+        Serial.println("[boot] Unfinished pack install, resuming");
     } else {
         packInstalled = false;
         appState = AppState::NoPack;
@@ -84,8 +92,12 @@ void setup() {
 
 // Render the "No Pack Installed" screen using strip-based rendering
 static void renderNoPack() {
+    // Static content: only repaints after switching from another screen
+    dirtyRegion.beginFrame(ScreenId::NoPack);
+
     for (int strip = 0; strip < NUM_STRIPS; strip++) {
         int stripY = strip * STRIP_H;
+        if (!dirtyRegion.needsStrip(stripY)) continue;
         TFT_eSprite& spr = display.getStrip();
         spr.fillSprite(CLR_BG_DARK);
 
@@ -146,6 +158,8 @@ static void renderNoPack() {
 
         display.pushStrip(stripY);
     }
+    display.waitStrips();
+    dirtyRegion.endFrame();
 }
 
 void loop() {
@@ -187,7 +201,7 @@ void loop() {
                     // Check if settings closed (via close button or back)
                     if (!settingsUI.isActive()) {
                         appState = packInstalled ? AppState::Cards : AppState::NoPack;
-                        // Reload font + image buffer that were freed for TLS
+                        // Reload the font that was freed for TLS
                         if (appState == AppState::Cards) {
                             imageRenderer::init();
                             cardScreen::reloadFont();
@@ -198,7 +212,7 @@ void loop() {
                     settingsUI.hide();
                     settingsMgr.save();
                     appState = packInstalled ? AppState::Cards : AppState::NoPack;
-                    // Reload font + image buffer that were freed for TLS
+                    // Reload the font that was freed for TLS
                     if (appState == AppState::Cards) {
                         imageRenderer::init();
                         cardScreen::reloadFont();
@@ -213,7 +227,9 @@ void loop() {
         }
     }
 
-    // (Download completion is handled by ESP.restart() in ui_settings.cpp)
+    // Pack download: one bounded step per loop, so touch and Wi-Fi stay live
+    // (completion is handled by ESP.restart() in ui_settings.cpp)
+    if (appState == AppState::Settings && settingsUI.update()) needsRender = true;
 
     // Card rotation (only in card mode)
     if (appState == AppState::Cards && !settingsUI.isActive()) {
@@ -222,7 +238,7 @@ void loop() {
         cardMgr.checkDayChange();
     }
 
-    // Render at demand or 1Hz refresh
+    // Render at demand or 1Hz refresh (only strips that changed are pushed)
     if (needsRender || now - lastRender > 1000) {
         switch (appState) {
             case AppState::Cards:
@@ -234,18 +250,14 @@ void loop() {
                 break;
 
             case AppState::Settings:
-            case AppState::Downloading: {
-                TFT_eSprite& spr = display.getStrip();
-                for (int strip = 0; strip < NUM_STRIPS; strip++) {
-                    int stripY = strip * STRIP_H;
-                    spr.fillSprite(CLR_BG_DARK);
-                    settingsUI.draw(spr, stripY);
-                    display.pushStrip(stripY);
-                }
+            case AppState::Downloading:
+                settingsUI.render();
                 break;
-            }
         }
         lastRender = now;
         needsRender = false;
+    } else if (appState == AppState::Cards && !settingsUI.isActive()) {
+        // Idle: decode the next card's image so the next tap doesn't wait on SPIFFS
+        cardMgr.prefetchNext();
     }
 }
@@ -1,12 +1,16 @@
 #include "pack_manager.h"
+#include "asset_store.h"
 #include "settings_manager.h"
 #include "wifi_manager.h"
 #include <Arduino.h>
+#include <Esp.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <FS.h>
 #include <SPIFFS.h>
+#include <esp_rom_crc.h>
+#include <cstdarg>
 #include <cstring>
 
 static const char* BASE_URL = "https://www.vcodeworks.dev/api/osmosis";
@@ -15,336 +19,1644 @@ static PackDownloadState _state = PackDownloadState::Idle;
 static uint8_t _progress = 0;
 static char _statusBuf[48] = "";
 
-// Catalog data
-static const uint8_t MAX_LANGUAGES = 20;
-static const uint8_t MAX_TIERS = 6;
-static CatalogLanguage _languages[MAX_LANGUAGES];
-static CatalogTier _tiers[MAX_LANGUAGES][MAX_TIERS];
+// Catalog data, on the heap and sized to the catalog. Tiers are stored
+// language after language; language i's are _tierStart[i] to _tierStart[i + 1].
+static const uint8_t MAX_LANGUAGES = 255;
+static const uint8_t MAX_TIERS = 255;            // Per language
+static const uint16_t MAX_CATALOG_TIERS = 1024;
+static CatalogLanguage* _languages = nullptr;
+static CatalogTier* _tiers = nullptr;
+static uint16_t* _tierStart = nullptr;
 static uint8_t _langCount = 0;
-static uint8_t _tierCounts[MAX_LANGUAGES] = {};
 static bool _catalogLoaded = false;
 
+static CatalogTier& tierAt(uint8_t li, uint8_t ti) { return _tiers[_tierStart[li] + ti]; }
+static uint8_t tiersOf(uint8_t li) { return _tierStart[li + 1] - _tierStart[li]; }
+static uint8_t _catalogRevision = 0;    // Bumped whenever the tables are replaced
+static bool _refreshPending = false;
+
+// Parsed catalog.json with the validators it was served with, so the
+// browser opens without a request and an unchanged catalog costs a 304.
+// Format:
+//   "OCAT", u8 format version, u8 language count, u16 tier count,
+//   ETag (64 bytes) and Last-Modified (32 bytes), NUL-padded,
+//   CatalogLanguage[languages], u16 tier start[languages + 1], CatalogTier[tiers]
+static const char* CATALOG_CACHE_PATH = "/catalog.bin";
+static const char* CATALOG_CACHE_TMP = "/catalog.tmp";
+static const uint8_t CATALOG_CACHE_FORMAT = 2;
+
+// Fields of catalog.json the tables keep; everything else is skipped while
+// parsing instead of being stored in the document
+static const char* CATALOG_FILTER =
+    "{\"languages\":[{\"id\":true,\"name\":true,\"flag\":true,\"tiers\":[{\"id\":true,"
+    "\"name\":true,\"words\":true,\"version\":true,\"manifestSize\":true,\"fontSize\":true}]}]}";
+static char _catalogEtag[64] = "";
+static char _catalogModified[32] = "";
+
 // Download state
 static uint8_t _dlLangIdx = 0;
 static uint8_t _dlTierIdx = 0;
+static char _dlPack[40] = "";        // "<language>/<tier>", outlives a catalog refresh
+static bool _oldPackIntact = false;  // The pack installed before this one is still whole
 static uint16_t _emojiTotal = 0;
 static uint16_t _emojiDone = 0;
-static packMgr::ProgressCallback _progressCb = nullptr;
+static uint16_t _filesCleared = 0;
+static bool _fontNeeded = false;
+static uint16_t _missingEmoji = 0;
+static uint32_t _missingBytes = 0;   // Font and emoji still to download
 
-// List of emoji codepoints from the downloaded manifest
+// Where the download is. Each update() runs one bounded piece of the
+// current step, so touch, rendering and Wi-Fi keep being serviced.
+enum class DownloadStep : uint8_t {
+    None,
+    Resume,         // Journalled install: waiting for Wi-Fi and the catalog
+    Prepare,        // Load the inventory of files already on SPIFFS
+    WipeStorage,    // No inventory yet: delete everything, WIPE_BATCH per update()
+    Manifest,
+    VocabPack,      // Optional
+    AssetList,      // Optional: sizes and hashes, so held files are recognised
+    Plan,           // Work out what is missing
+    MakeRoom,       // Delete unused files until the missing ones fit the budget
+    Font,           // Only if the held font differs
+    EmojiBundle,    // emoji.bundle, split onto the assets partition as it arrives
+    Emoji,          // Anything the bundle lacked, one file in flight at a time
+    Collect,        // Trim unused files to the storage budget
+    Finish
+};
+static DownloadStep _step = DownloadStep::None;
+
+// Where a catalog fetch is, on the same connection and update() calls as
+// the install: the request, its body onto SPIFFS a bounded piece per call,
+// then the parse of the whole file
+enum class CatalogStep : uint8_t { None, Request, Body, Parse };
+static CatalogStep _catalogStep = CatalogStep::None;
+static const char* CATALOG_BODY_PATH = "/catalog.json";  // Only until it is parsed (tens of KB)
+static char _bodyEtag[sizeof(_catalogEtag)];              // Validators of that body
+static char _bodyModified[sizeof(_catalogModified)];
+static bool _catalogBackground = false;                   // A refresh, not fetchCatalog()
+static PackDownloadState _stateBefore;                    // Shown again after a refresh
+static uint32_t _catalogStartMs = 0;
+
+// Distinct emoji of the downloaded manifest, in word order. Each is a single
+// codepoint whose file is "<lowercase hex>.bin".
 static const uint16_t MAX_EMOJI = 350;
-static char _emojiList[MAX_EMOJI][12];
+static uint32_t _emojiCps[MAX_EMOJI];
 static uint16_t _emojiCount = 0;
 
-static bool httpDownloadToSpiffs(const char* url, const char* path) {
+static const uint8_t WIPE_BATCH = 10;              // Files deleted per update()
+// Free space on the assets partition comes in gaps between held files that
+// only writes small enough can use: files no install uses are only kept
+// while usage stays below this
+static const uint8_t STORAGE_BUDGET_PCT = 75;
+static const uint32_t EST_EMOJI_BYTES = 8192;      // Size of an emoji without an asset list
+static const size_t TRANSFER_CHUNK = 2048;         // Bytes copied per update()
+static const uint32_t TRANSFER_TIMEOUT_MS = 15000; // Give up after this long without data
+
+// A file that fails in a way that may pass (no connection, a 5xx, a body
+// cut short) is fetched again after RETRY_BASE_MS, doubling each time
+static const uint8_t MAX_ATTEMPTS = 4;
+static const uint32_t RETRY_BASE_MS = 1000;
+static const uint8_t MAX_BACKOFF_SHIFT = 5;        // Resume waits at most 32 s between catalog tries
+static uint8_t _attempt = 0;                       // Retries of the current file so far
+static bool _retrying = false;
+static uint32_t _retryAtMs = 0;
+
+// Install journal: the pack being installed, on SPIFFS from startDownload()
+// until the install completes or is cancelled. A device that boots with one
+// resumes that install instead of loading the partial pack; files it had
+// already downloaded are in the inventory (see asset_store.h). Format:
+//   "OJNL", u8 format version, u8 pack version, u16 reserved,
+//   NUL-padded language id (16 bytes), NUL-padded tier id (16 bytes)
+static const char* JOURNAL_PATH = "/install.journal";
+static const uint8_t JOURNAL_FORMAT = 1;
+static const uint8_t JOURNAL_SIZE = 40;
+static char _resumeLang[sizeof(CatalogLanguage::id)];
+static char _resumeTier[sizeof(CatalogTier::id)];
+static uint8_t _resumeVersion = 0;
+
+enum class TransferResult : uint8_t { Pending, Done, Failed };
+
+// Chunked transfer-encoding parser position (HTTP/1.1 bodies without a length)
+enum class ChunkState : uint8_t { Size, Extension, Data, DataEnd, Trailer, Done };
+
+// The one HTTP transfer in flight: response body streamed into a SPIFFS file
+// or, for the font and emoji, onto the assets partition (see asset_store.h).
+// client stays connected between files, so a whole install normally costs a
+// single TLS handshake; HTTPClient reuses the open connection on the next GET.
+static struct {
     WiFiClientSecure client;
-    client.setInsecure();  // Skip TLS cert verification
     HTTPClient http;
-    http.begin(client, url);
-    http.setTimeout(15000);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    int code = http.GET();
+    fs::File file;
+    char path[32];
+    int32_t size;        // Content-Length, -1 when chunked
+    uint32_t received;   // Body bytes written to file
+    uint32_t crc;        // CRC-32 of them, checked against assets.idx at the end
+    uint32_t lastDataMs;
+    bool active;
+    bool toBundle;       // Body goes through bundleWrite() instead of into file
+    bool toAsset;        // Body goes to assetStore as path without its '/'
+    bool toCatalog;      // catalog.json: counted in _catalogStats, not the install's
+    bool chunked;
+    ChunkState chunk;
+    uint32_t chunkLeft;  // Data bytes left in the current chunk
+    uint8_t lineLen;     // Trailer line length so far
+    PackPhase phase;     // Where its bytes and time are counted
+    uint32_t startMs;    // Request sent
+    bool retryable;      // Failed in a way worth trying again
+} _xfer;
+
+// emoji.bundle being split (format in tools/build_pack.py)
+static const uint8_t BUNDLE_FORMAT = 1;
+static const uint8_t BUNDLE_HEADER = 8;
+static const uint8_t BUNDLE_ENTRY = 20;      // Name, offset, size
+static const uint8_t BUNDLE_NAME_LEN = 12;
+static struct {
+    uint8_t header[BUNDLE_HEADER];
+    uint8_t* index;      // count * BUNDLE_ENTRY bytes, freed when the bundle ends
+    uint16_t count;
+    uint32_t pos;        // Bundle bytes consumed
+    uint16_t entry;      // Image being written
+    uint32_t entryLeft;  // Bytes of it still to come
+    bool skip;           // Already held: its bytes are dropped
+    bool writing;        // Not held: its bytes go to assetStore
+    uint32_t crc;        // CRC-32 of the image so far
+} _bundle;
+
+// Pulls emoji codepoints out of manifest.json as it downloads: every string
+// value of an "emoji" key, deduplicated through an open-addressed hash set
+static const uint16_t EMOJI_SET_SLOTS = 512;  // Power of two, over 2 * MAX_EMOJI
+static const uint16_t EMOJI_SET_EMPTY = 0xFFFF;
+static const uint8_t SCAN_TOKEN_LEN = 8;      // Longer strings are never "emoji" or a codepoint
+enum class ScanState : uint8_t { Other, AfterString, AfterKey, Value };
+static struct {
+    uint16_t* set;       // EMOJI_SET_SLOTS indices into _emojiCps, during the manifest only
+    ScanState state;
+    bool inString;
+    bool escape;
+    bool keyIsEmoji;     // The last string, if it turns out to be a key
+    char token[SCAN_TOKEN_LEN + 1];
+    uint8_t len;         // SCAN_TOKEN_LEN + 1 once the string is too long
+    uint16_t dropped;    // Emoji past MAX_EMOJI or not a single codepoint
+} _scan;
+
+static PackInstallStats _stats = {};
+static PackPhaseStats _catalogStats = {};  // Last catalog fetch, copied into each install's stats
+static uint32_t _installStartMs = 0;
+
+// Closes the kept-alive connection (end of install, or after a failure that
+// leaves unread response bytes on it)
+static void closeConnection() {
+    _xfer.http.end();
+    _xfer.client.stop();
+}
+
+// snprintf() onto the end of buf; pos keeps counting past len like snprintf does
+static void appendf(char* buf, size_t len, size_t& pos, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(pos < len ? buf + pos : nullptr, pos < len ? len - pos : 0, fmt, args);
+    va_end(args);
+    if (n > 0) pos += n;
+}
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const char* bundleName(uint16_t entry) {
+    return (const char*)_bundle.index + (uint32_t)entry * BUNDLE_ENTRY;
+}
+
+static uint32_t bundleEntrySize(uint16_t entry) {
+    return readLe32(_bundle.index + (uint32_t)entry * BUNDLE_ENTRY + BUNDLE_NAME_LEN + 4);
+}
+
+// Checks a file just written against its assets.idx entry; files it doesn't
+// list with a hash pass. A mismatch is never recorded as held, so the file
+// is fetched again instead of failing to decode at render time.
+static bool contentIntact(const char* name, uint32_t size, uint32_t crc) {
+    const AssetRecord* a = assetStore::asset(name);
+    if (!a || a->crc == 0 || (a->size == size && a->crc == crc)) return true;
+    Serial.printf("[pack] %s is corrupt (%u bytes, CRC %08x; listed %u bytes, CRC %08x)\n",
+                  name, size, crc, a->size, a->crc);
+    _stats.rejected++;
+    return false;
+}
+
+static bool bundleComplete() {
+    return _bundle.pos >= BUNDLE_HEADER && _bundle.index != nullptr && _bundle.entry == _bundle.count;
+}
+
+// Frees the index; an image cut off part-way is dropped, finished ones stay
+static void endBundle() {
+    if (_bundle.writing) assetStore::abortWrite();
+    _bundle.writing = false;
+    free(_bundle.index);
+    _bundle.index = nullptr;
+}
+
+// The index must name every image once, in file order with no gaps, each
+// large enough for an ORLE header
+static bool bundleIndexValid() {
+    uint32_t expected = BUNDLE_HEADER + (uint32_t)_bundle.count * BUNDLE_ENTRY;
+    for (uint16_t i = 0; i < _bundle.count; i++) {
+        const uint8_t* e = _bundle.index + (uint32_t)i * BUNDLE_ENTRY;
+        if (e[0] == '\0' || e[BUNDLE_NAME_LEN - 1] != '\0') return false;
+        if (strchr((const char*)e, '/')) return false;
+        if (readLe32(e + BUNDLE_NAME_LEN) != expected) return false;
+        uint32_t size = bundleEntrySize(i);
+        if (size < 12) return false;
+        expected += size;
+    }
+    return true;
+}
+
+// Splits bundle bytes as they arrive: header, then index, then each image
+// into assetStore as <codepoint>.bin
+static bool bundleWrite(const uint8_t* data, size_t n) {
+    while (n > 0) {
+        size_t take;
+        if (_bundle.pos < BUNDLE_HEADER) {
+            take = BUNDLE_HEADER - _bundle.pos;
+            if (take > n) take = n;
+            memcpy(_bundle.header + _bundle.pos, data, take);
+            _bundle.pos += take;
+            data += take;
+            n -= take;
+            if (_bundle.pos < BUNDLE_HEADER) continue;
+
+            if (memcmp(_bundle.header, "OEBN", 4) != 0 || _bundle.header[4] != BUNDLE_FORMAT) {
+                Serial.println("[pack] Not an emoji bundle");
+                return false;
+            }
+            _bundle.count = _bundle.header[6] | (_bundle.header[7] << 8);
+            _bundle.index = (uint8_t*)malloc((uint32_t)_bundle.count * BUNDLE_ENTRY + 1);
+            if (!_bundle.index) {
+                Serial.printf("[pack] No heap for a %u-image bundle index\n", _bundle.count);
+                return false;
+            }
+            continue;
+        }
+
+        uint32_t indexEnd = BUNDLE_HEADER + (uint32_t)_bundle.count * BUNDLE_ENTRY;
+        if (_bundle.pos < indexEnd) {
+            take = indexEnd - _bundle.pos;
+            if (take > n) take = n;
+            memcpy(_bundle.index + (_bundle.pos - BUNDLE_HEADER), data, take);
+            _bundle.pos += take;
+            data += take;
+            n -= take;
+            if (_bundle.pos == indexEnd && !bundleIndexValid()) {
+                Serial.println("[pack] Bad emoji bundle index");
+                return false;
+            }
+            continue;
+        }
+
+        if (_bundle.entry >= _bundle.count) return false;  // Bytes past the last image
+        char name[BUNDLE_NAME_LEN + 4];
+        snprintf(name, sizeof(name), "%s.bin", bundleName(_bundle.entry));
+        if (!_bundle.writing && !_bundle.skip) {
+            _bundle.entryLeft = bundleEntrySize(_bundle.entry);
+            _bundle.skip = assetStore::has(name);
+            _bundle.crc = 0;
+            if (!_bundle.skip) {
+                if (!assetStore::beginWrite(name, _bundle.entryLeft)) {
+                    Serial.printf("[pack] Failed to open %s for writing\n", name);
+                    return false;
+                }
+                _bundle.writing = true;
+            }
+        }
+        take = _bundle.entryLeft;
+        if (take > n) take = n;
+        if (!_bundle.skip) {
+            if (!assetStore::write(data, take)) {
+                Serial.printf("[pack] Write failed for %s (SPIFFS full?)\n", name);
+                return false;
+            }
+            _bundle.crc = esp_rom_crc32_le(_bundle.crc, data, take);
+        }
+        _bundle.pos += take;
+        _bundle.entryLeft -= take;
+        data += take;
+        n -= take;
+        if (_bundle.entryLeft == 0) {
+            if (!_bundle.skip) {
+                // A corrupt image is left to the single downloads after the bundle
+                if (contentIntact(name, bundleEntrySize(_bundle.entry), _bundle.crc)) {
+                    assetStore::commitWrite();
+                } else {
+                    assetStore::abortWrite();
+                }
+                _bundle.writing = false;
+            }
+            _bundle.skip = false;
+            _bundle.entry++;
+        }
+    }
+    return true;
+}
+
+static void countTransfer() {
+    uint32_t ms = millis() - _xfer.startMs;
+    PackPhaseStats& p = _stats.phase[(uint8_t)_xfer.phase];
+    p.ms += ms;
+    p.files++;
+    uint8_t b = 0;
+    while (b < PACK_LATENCY_BUCKETS - 1 && ms >= PACK_LATENCY_MS[b]) b++;
+    _stats.latency[b]++;
+}
+
+static void endTransfer(bool keepFile) {
+    if (!_xfer.active) return;
+    if (!_xfer.toCatalog) countTransfer();
+    if (_xfer.file) _xfer.file.close();
+    if (_xfer.toAsset) assetStore::abortWrite();  // Unless already committed
+    if (keepFile) {
+        _xfer.http.end();  // Leaves the connection open for the next file
+    } else {
+        closeConnection();
+        if (!_xfer.toBundle && !_xfer.toAsset) SPIFFS.remove(_xfer.path);
+    }
+    if (_xfer.toBundle) endBundle();
+    _xfer.active = false;
+}
+
+static int sendGet(const char* url) {
+    static const char* headerKeys[] = {"Transfer-Encoding"};
+    // A dropped connection is reopened by GET(); count that as a handshake
+    bool connecting = !_xfer.client.connected();
+    if (connecting) _stats.handshakes++;
+    _stats.requests++;
+    _xfer.http.begin(_xfer.client, url);
+    _xfer.http.setTimeout(15000);
+    _xfer.http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    _xfer.http.setReuse(true);
+    _xfer.http.collectHeaders(headerKeys, 1);
+    uint32_t startMs = millis();
+    int code = _xfer.http.GET();
+    if (connecting) _stats.connectMs += millis() - startMs;
+    return code;
+}
+
+static PackPhase phaseOf(DownloadStep step) {
+    switch (step) {
+        case DownloadStep::Font:
+            return PackPhase::Font;
+        case DownloadStep::EmojiBundle:
+        case DownloadStep::Emoji:
+            return PackPhase::Emoji;
+        default:
+            return PackPhase::Manifest;  // With vocab.pack and assets.idx
+    }
+}
+
+// Framing of the response whose headers were just read
+static void beginBody() {
+    _xfer.size = _xfer.http.getSize();  // -1 if chunked
+    _xfer.chunked = _xfer.http.header("Transfer-Encoding").indexOf("chunked") >= 0;
+    _xfer.chunk = ChunkState::Size;
+    _xfer.chunkLeft = 0;
+    _xfer.lineLen = 0;
+    _xfer.received = 0;
+    _xfer.crc = 0;
+}
+
+// path nullptr: the emoji bundle. asset: path names an assetStore file, not a SPIFFS one.
+static bool beginTransfer(const char* url, const char* path, bool asset = false) {
+    endTransfer(false);
+    _xfer.retryable = false;
+    _xfer.client.setInsecure();  // Skip TLS cert verification
+    bool reused = _xfer.client.connected();
+    _xfer.phase = phaseOf(_step);
+    _xfer.startMs = millis();
+    int code = sendGet(url);
+    if (code < 0 && reused) {
+        // The server dropped the idle connection: retry once on a fresh one
+        Serial.printf("[pack] Connection lost (%d), reconnecting\n", code);
+        closeConnection();
+        _stats.retries++;
+        code = sendGet(url);
+    }
 
     if (code != 200) {
         Serial.printf("[pack] HTTP %d for %s\n", code, url);
-        http.end();
+        closeConnection();  // Unread error body would corrupt the next response
+        _xfer.retryable = code < 0 || code >= 500;  // Not a missing file
         return false;
     }
 
-    int contentLen = http.getSize();  // -1 if chunked
-    Serial.printf("[pack] Downloading %s (%d bytes, chunked=%s)\n",
-                  path, contentLen, (contentLen < 0) ? "yes" : "no");
+    _xfer.toBundle = (path == nullptr);
+    _xfer.toAsset = asset;
+    _xfer.toCatalog = false;
+    if (_xfer.toBundle) {
+        _bundle.pos = 0;
+        _bundle.count = 0;
+        _bundle.entry = 0;
+        _bundle.entryLeft = 0;
+        _bundle.skip = false;
+        _bundle.writing = false;
+        path = "emoji.bundle";  // Only for logs: nothing is written under this name
+    } else if (asset) {
+        // Sized from the response, else from assets.idx, so it can go in a gap
+        const AssetRecord* a = assetStore::asset(path + 1);
+        int32_t size = _xfer.http.getSize();
+        if (!assetStore::beginWrite(path + 1, size >= 0 ? (uint32_t)size : a ? a->size : 0)) {
+            Serial.printf("[pack] Failed to open %s for writing\n", path);
+            closeConnection();
+            return false;
+        }
+    } else {
+        _xfer.file = SPIFFS.open(path, "w");
+        if (!_xfer.file) {
+            Serial.printf("[pack] Failed to open %s for writing\n", path);
+            closeConnection();
+            return false;
+        }
+    }
 
-    fs::File f = SPIFFS.open(path, "w");
-    if (!f) {
-        Serial.printf("[pack] Failed to open %s for writing\n", path);
-        http.end();
-        return false;
+    strlcpy(_xfer.path, path, sizeof(_xfer.path));
+    beginBody();
+    _xfer.lastDataMs = millis();
+    _xfer.active = true;
+    Serial.printf("[pack] Downloading %s (%d bytes, chunked=%s, heap: %u)\n",
+                  path, (int)_xfer.size, _xfer.chunked ? "yes" : "no",
+                  (uint32_t)ESP.getFreeHeap());
+    return true;
+}
+
+static bool beginEmojiScan() {
+    free(_scan.set);
+    _scan = {};
+    _scan.set = (uint16_t*)malloc(EMOJI_SET_SLOTS * sizeof(uint16_t));
+    if (!_scan.set) return false;
+    memset(_scan.set, 0xFF, EMOJI_SET_SLOTS * sizeof(uint16_t));
+    _emojiCount = 0;
+    return true;
+}
+
+static void endEmojiScan() {
+    free(_scan.set);
+    _scan.set = nullptr;
+}
+
+// Parses a codepoint written the way emoji files are named; false for
+// anything else (uppercase, leading zeros, sequences)
+static bool parseCodepoint(const char* s, uint8_t len, uint32_t& cp) {
+    if (len == 0 || len > 6 || s[0] == '0') return false;
+    cp = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (c >= '0' && c <= '9') cp = (cp << 4) | (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') cp = (cp << 4) | (uint32_t)(c - 'a' + 10);
+        else return false;
     }
+    return true;
+}
 
-    // Use writeToStream which properly handles chunked transfer encoding
-    Serial.printf("[pack] Free heap before write: %u\n", (uint32_t)ESP.getFreeHeap());
-    int written = http.writeToStream(&f);
-    f.close();
-    http.end();
+static void addEmoji() {
+    uint32_t cp;
+    if (_scan.len == 0) return;  // Word without an image
+    if (_scan.len > SCAN_TOKEN_LEN || !parseCodepoint(_scan.token, _scan.len, cp)) {
+        _scan.dropped++;
+        return;
+    }
+    uint16_t slot = (uint16_t)((cp * 2654435761u) >> 23) & (EMOJI_SET_SLOTS - 1);
+    while (_scan.set[slot] != EMOJI_SET_EMPTY) {
+        if (_emojiCps[_scan.set[slot]] == cp) return;  // Already listed
+        slot = (slot + 1) & (EMOJI_SET_SLOTS - 1);
+    }
+    if (_emojiCount >= MAX_EMOJI) {
+        _scan.dropped++;
+        return;
+    }
+    _scan.set[slot] = _emojiCount;
+    _emojiCps[_emojiCount++] = cp;
+}
 
-    if (written < 0) {
-        Serial.printf("[pack] writeToStream failed: %d for %s (heap: %u)\n",
-                      written, path, (uint32_t)ESP.getFreeHeap());
-        SPIFFS.remove(path);
-        return false;
+// Tracks just enough JSON to tell keys from values: a string followed by
+// ':' is a key, and a string right after the key "emoji" is its value
+static void scanEmoji(const uint8_t* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        char c = (char)data[i];
+        if (_scan.inString) {
+            if (_scan.escape) {
+                _scan.escape = false;
+                _scan.len = SCAN_TOKEN_LEN + 1;  // Escapes never appear in a codepoint
+            } else if (c == '\\') {
+                _scan.escape = true;
+            } else if (c == '"') {
+                _scan.inString = false;
+                if (_scan.state == ScanState::Value) {
+                    addEmoji();
+                    _scan.state = ScanState::Other;
+                } else {
+                    _scan.keyIsEmoji = _scan.len == 5 && memcmp(_scan.token, "emoji", 5) == 0;
+                    _scan.state = ScanState::AfterString;
+                }
+            } else if (_scan.len < SCAN_TOKEN_LEN) {
+                _scan.token[_scan.len++] = c;
+            } else {
+                _scan.len = SCAN_TOKEN_LEN + 1;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') continue;
+        if (c == '"') {
+            _scan.inString = true;
+            _scan.len = 0;
+            if (_scan.state == ScanState::AfterKey) _scan.state = ScanState::Value;
+            else _scan.state = ScanState::Other;
+        } else if (c == ':' && _scan.state == ScanState::AfterString && _scan.keyIsEmoji) {
+            _scan.state = ScanState::AfterKey;
+        } else {
+            _scan.state = ScanState::Other;
+        }
     }
+}
+
+// "<codepoint>.bin" for entry i of _emojiCps
+static void emojiFileName(uint16_t i, char* out, size_t n) {
+    snprintf(out, n, "%x.bin", (unsigned)_emojiCps[i]);
+}
 
-    Serial.printf("[pack] Downloaded %s (%d bytes)\n", path, written);
+static bool writeBody(const uint8_t* data, size_t n) {
+    if (n == 0) return true;
+    if (_scan.set) scanEmoji(data, n);
+    if (_xfer.toBundle) {
+        if (!bundleWrite(data, n)) return false;
+    } else if (_xfer.toAsset ? !assetStore::write(data, n) : _xfer.file.write(data, n) != n) {
+        Serial.printf("[pack] Write failed for %s (SPIFFS full?)\n", _xfer.path);
+        return false;
+    } else {
+        _xfer.crc = esp_rom_crc32_le(_xfer.crc, data, n);
+    }
+    _xfer.received += n;
+    if (_xfer.toCatalog) return true;
+    _stats.bytes += n;
+    _stats.phase[(uint8_t)_xfer.phase].bytes += n;
     return true;
 }
 
-namespace packMgr {
+static int hexDigit(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
 
-bool fetchCatalog() {
-    if (!wifiMgr::isConnected()) {
-        Serial.println("[pack] WiFi not connected");
-        return false;
+// Strips chunked framing from raw response bytes, passing the data to emit;
+// false if emit fails or the framing is malformed
+static bool decodeChunked(const uint8_t* buf, size_t n, bool (*emit)(const uint8_t*, size_t)) {
+    size_t i = 0;
+    while (i < n && _xfer.chunk != ChunkState::Done) {
+        uint8_t c = buf[i];
+        switch (_xfer.chunk) {
+            case ChunkState::Size:
+            case ChunkState::Extension:
+                i++;
+                if (c == '\n') {
+                    _xfer.chunk = _xfer.chunkLeft ? ChunkState::Data : ChunkState::Trailer;
+                } else if (c == ';') {
+                    _xfer.chunk = ChunkState::Extension;
+                } else if (_xfer.chunk == ChunkState::Size && c != '\r') {
+                    int d = hexDigit(c);
+                    if (d < 0 || _xfer.chunkLeft > 0x0FFFFFFF) return false;
+                    _xfer.chunkLeft = (_xfer.chunkLeft << 4) | d;
+                }
+                break;
+            case ChunkState::Data: {
+                size_t take = n - i;
+                if (take > _xfer.chunkLeft) take = _xfer.chunkLeft;
+                if (!emit(buf + i, take)) return false;
+                i += take;
+                _xfer.chunkLeft -= take;
+                if (_xfer.chunkLeft == 0) _xfer.chunk = ChunkState::DataEnd;
+                break;
+            }
+            case ChunkState::DataEnd:
+                // CRLF after the chunk data
+                i++;
+                if (c == '\n') _xfer.chunk = ChunkState::Size;
+                break;
+            case ChunkState::Trailer:
+                // Optional trailer headers, ended by an empty line
+                i++;
+                if (c == '\n') {
+                    if (_xfer.lineLen == 0) _xfer.chunk = ChunkState::Done;
+                    _xfer.lineLen = 0;
+                } else if (c != '\r' && _xfer.lineLen < 255) {
+                    _xfer.lineLen++;
+                }
+                break;
+            case ChunkState::Done:
+                break;
+        }
     }
+    return true;
+}
 
-    _state = PackDownloadState::FetchingCatalog;
-    strlcpy(_statusBuf, "Fetching catalog...", sizeof(_statusBuf));
+static bool bodyComplete() {
+    if (_xfer.chunked) return _xfer.chunk == ChunkState::Done;
+    return _xfer.size >= 0 && _xfer.received >= (uint32_t)_xfer.size;
+}
 
-    char url[128];
-    snprintf(url, sizeof(url), "%s/catalog.json", BASE_URL);
+// Raw bytes that can be read now without passing the end of the body
+static size_t bodyReadLimit(size_t n) {
+    if (_xfer.chunked) {
+        // Within chunk data the framing is known not to start yet
+        if (_xfer.chunk == ChunkState::Data && n > _xfer.chunkLeft) n = _xfer.chunkLeft;
+        else if (_xfer.chunk != ChunkState::Data) n = 1;
+    } else if (_xfer.size >= 0 && n > (uint32_t)_xfer.size - _xfer.received) {
+        n = (uint32_t)_xfer.size - _xfer.received;
+    }
+    return n;
+}
 
-    WiFiClientSecure client;
-    client.setInsecure();  // Skip TLS cert verification
-    HTTPClient http;
-    http.begin(client, url);
-    http.setTimeout(10000);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    Serial.printf("[pack] Fetching: %s (heap: %u)\n", url, (uint32_t)ESP.getFreeHeap());
-    int code = http.GET();
-    Serial.printf("[pack] HTTP response: %d\n", code);
+// Copies whatever has arrived, at most TRANSFER_CHUNK bytes, without waiting.
+// Never reads past the end of this response: the connection carries the next.
+static TransferResult pumpTransfer() {
+    WiFiClient* stream = _xfer.http.getStreamPtr();
+    uint8_t buf[512];
+    size_t budget = TRANSFER_CHUNK;
 
-    if (code != 200) {
-        Serial.printf("[pack] Catalog fetch failed: HTTP %d\n", code);
-        _state = PackDownloadState::Error;
-        strlcpy(_statusBuf, "Catalog fetch failed", sizeof(_statusBuf));
-        http.end();
-        return false;
+    while (budget > 0 && !bodyComplete()) {
+        int avail = stream->available();
+        if (avail <= 0) break;
+        size_t n = (size_t)avail;
+        if (n > sizeof(buf)) n = sizeof(buf);
+        if (n > budget) n = budget;
+        n = bodyReadLimit(n);
+        int got = stream->read(buf, n);
+        if (got <= 0) break;
+        bool ok = _xfer.chunked ? decodeChunked(buf, got, writeBody) : writeBody(buf, got);
+        if (!ok) {
+            if (_xfer.chunked) Serial.printf("[pack] Bad chunked body for %s\n", _xfer.path);
+            return TransferResult::Failed;  // Not retryable: the same bytes would fail again
+        }
+        _xfer.lastDataMs = millis();
+        budget -= got;
+    }
+
+    bool closed = !stream->connected() && stream->available() <= 0;
+    // Without a length or chunking, the body ends when the server closes
+    if (bodyComplete() || (closed && !_xfer.chunked && _xfer.size < 0)) {
+        Serial.printf("[pack] Downloaded %s (%u bytes)\n", _xfer.path, _xfer.received);
+        return TransferResult::Done;
     }
+    if (closed) {
+        Serial.printf("[pack] Connection closed after %u of %d bytes for %s\n",
+                      _xfer.received, (int)_xfer.size, _xfer.path);
+        _xfer.retryable = true;
+        return TransferResult::Failed;
+    }
+    if (millis() - _xfer.lastDataMs > TRANSFER_TIMEOUT_MS) {
+        Serial.printf("[pack] Timed out on %s\n", _xfer.path);
+        _xfer.retryable = true;
+        return TransferResult::Failed;
+    }
+    return TransferResult::Pending;
+}
 
-    String payload = http.getString();
-    http.end();
+static void sampleHeap() {
+    uint32_t free = ESP.getFreeHeap();
+    uint32_t block = ESP.getMaxAllocHeap();
+    if (free < _stats.minFreeHeap) _stats.minFreeHeap = free;
+    if (block < _stats.minMaxAlloc) _stats.minMaxAlloc = block;
+}
 
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, payload);
-    if (err) {
-        Serial.printf("[pack] Catalog JSON error: %s\n", err.c_str());
-        _state = PackDownloadState::Error;
-        return false;
+// Closes the install with its outcome and logs its metrics record
+static void endInstall(PackDownloadState result) {
+    closeConnection();
+    endEmojiScan();
+    // Whatever was downloaded before a failure or cancel is tracked too,
+    // unless untracked files may still be left from before the inventory
+    if (_step > DownloadStep::WipeStorage) assetStore::save();
+    assetStore::release();
+    sampleHeap();
+    _stats.ms = millis() - _installStartMs;
+    _step = DownloadStep::None;
+    _state = result;
+
+    char json[640];
+    packMgr::installStatsJson(json, sizeof(json));
+    Serial.printf("[pack] metrics %s\n", json);
+}
+
+static void failDownload(const char* status) {
+    endTransfer(false);
+    endInstall(PackDownloadState::Error);
+    strlcpy(_statusBuf, status, sizeof(_statusBuf));
+}
+
+// Deletes one batch of files; true once only the journal and the catalog
+// cache are left. Only used when the files on SPIFFS aren't tracked yet
+// (first install without an inventory).
+static bool wipeBatch() {
+    char batch[WIPE_BATCH][32];
+    uint8_t batchCount = 0;
+    fs::File root = SPIFFS.open("/");
+    fs::File file = root.openNextFile();
+    while (file && batchCount < WIPE_BATCH) {
+        const char* name = file.name();
+        if (name[0] == '/') {
+            strlcpy(batch[batchCount], name, 32);
+        } else {
+            batch[batchCount][0] = '/';
+            strlcpy(batch[batchCount] + 1, name, 31);
+        }
+        // The journal names the install; the catalog cache isn't a pack file
+        if (strcmp(batch[batchCount], JOURNAL_PATH) != 0 &&
+            strcmp(batch[batchCount], CATALOG_CACHE_PATH) != 0) {
+            batchCount++;
+        }
+        file.close();
+        file = root.openNextFile();
     }
+    if (file) file.close();
+    root.close();
 
-    // Parse languages
-    JsonArray langs = doc["languages"];
-    _langCount = 0;
-    for (JsonObject lang : langs) {
-        if (_langCount >= MAX_LANGUAGES) break;
-        uint8_t li = _langCount;
-        strlcpy(_languages[li].id, lang["id"] | "", sizeof(_languages[li].id));
-        strlcpy(_languages[li].name, lang["name"] | "", sizeof(_languages[li].name));
-        strlcpy(_languages[li].flag, lang["flag"] | "", sizeof(_languages[li].flag));
+    for (uint8_t i = 0; i < batchCount; i++) {
+        SPIFFS.remove(batch[i]);
+        _filesCleared++;
+    }
+    return batchCount == 0;
+}
 
-        _tierCounts[li] = 0;
-        JsonArray tiers = lang["tiers"];
-        for (JsonObject t : tiers) {
-            if (_tierCounts[li] >= MAX_TIERS) break;
-            uint8_t ti = _tierCounts[li];
-            strlcpy(_tiers[li][ti].id, t["id"] | "", sizeof(_tiers[li][ti].id));
-            strlcpy(_tiers[li][ti].name, t["name"] | "", sizeof(_tiers[li][ti].name));
-            _tiers[li][ti].words = t["words"] | 0;
-            _tiers[li][ti].version = t["version"] | 0;
-            _tiers[li][ti].manifestSize = t["manifestSize"] | 0;
-            _tiers[li][ti].fontSize = t["fontSize"] | 0;
-            _tierCounts[li]++;
+// Works out what the pack needs that the device doesn't hold. Held files
+// are marked in use so garbage collection keeps them.
+static void planInstall() {
+    bool listed = assetStore::loadAssetList("/assets.idx");
+
+    // The font's name is the same for every language: without a hash it
+    // can't be told apart from another language's, so it is fetched again
+    const AssetRecord* font = assetStore::asset("font.vlw");
+    _fontNeeded = !font || font->crc == 0 || !assetStore::has("font.vlw");
+    _missingBytes = _fontNeeded ? (font ? font->size : 0) : 0;
+    if (!_fontNeeded) assetStore::markUsed("font.vlw");
+
+    _missingEmoji = 0;
+    for (uint16_t i = 0; i < _emojiCount; i++) {
+        char name[20];
+        emojiFileName(i, name, sizeof(name));
+        if (assetStore::has(name)) {
+            assetStore::markUsed(name);
+            continue;
         }
-        _langCount++;
+        const AssetRecord* a = assetStore::asset(name);
+        _missingEmoji++;
+        _missingBytes += a ? a->size : EST_EMOJI_BYTES;
     }
+    Serial.printf("[pack] Missing: font %s, %u of %u emoji, %u bytes (asset list: %s)\n",
+                  _fontNeeded ? "yes" : "no", _missingEmoji, _emojiCount, _missingBytes,
+                  listed ? "yes" : "no");
+}
 
-    _catalogLoaded = true;
-    _state = PackDownloadState::Idle;
-    Serial.printf("[pack] Catalog loaded: %d languages\n", _langCount);
-    return true;
+// The bundle pays off once most of the pack's emoji are missing; a few
+// missing ones are cheaper one by one over the kept-alive connection
+static bool bundleWorthIt() {
+    if (_missingEmoji == 0) return false;
+    uint32_t listed = assetStore::listedBytes(".bin");
+    if (listed == 0) return _missingEmoji * 2 >= _emojiCount;
+    uint32_t missing = _missingBytes;
+    const AssetRecord* font = assetStore::asset("font.vlw");
+    if (_fontNeeded && font) missing -= font->size;
+    return missing * 2 >= listed;
 }
 
-uint8_t languageCount() { return _langCount; }
-const CatalogLanguage& language(uint8_t i) { return _languages[i]; }
-uint8_t tierCount(uint8_t langIdx) { return _tierCounts[langIdx]; }
-const CatalogTier& tier(uint8_t langIdx, uint8_t tierIdx) { return _tiers[langIdx][tierIdx]; }
+static size_t storageBudget() {
+    return assetStore::totalBytes() * STORAGE_BUDGET_PCT / 100;
+}
 
-bool startDownload(uint8_t langIdx, uint8_t tierIdx) {
-    if (!wifiMgr::isConnected() || !_catalogLoaded) return false;
-    if (langIdx >= _langCount || tierIdx >= _tierCounts[langIdx]) return false;
+// Moves _emojiDone to the next emoji that isn't held yet; false when none are left
+static bool nextMissingEmoji() {
+    while (_emojiDone < _emojiCount) {
+        char name[20];
+        emojiFileName(_emojiDone, name, sizeof(name));
+        if (!assetStore::has(name)) return true;
+        assetStore::markUsed(name);  // Normally written from the bundle
+        _emojiDone++;
+    }
+    return false;
+}
 
+static bool writeJournal() {
+    const CatalogTier& t = tierAt(_dlLangIdx, _dlTierIdx);
+    uint8_t j[JOURNAL_SIZE] = {'O', 'J', 'N', 'L', JOURNAL_FORMAT, t.version};
+    memcpy(j + 8, _languages[_dlLangIdx].id, strnlen(_languages[_dlLangIdx].id, 16));
+    memcpy(j + 24, t.id, strnlen(t.id, 16));
+    fs::File f = SPIFFS.open(JOURNAL_PATH, "w");
+    bool ok = f && f.write(j, sizeof(j)) == sizeof(j);
+    if (f) f.close();
+    if (!ok) Serial.println("[pack] Failed to write install journal");
+    return ok;
+}
+
+// Language and tier ids and pack version of the journalled install; false
+// if there is none
+static bool readJournal(char* lang, char* tier, uint8_t& version) {
+    fs::File f = SPIFFS.open(JOURNAL_PATH, "r");
+    if (!f) return false;
+    uint8_t j[JOURNAL_SIZE];
+    bool ok = f.read(j, sizeof(j)) == sizeof(j) && memcmp(j, "OJNL", 4) == 0 &&
+              j[4] == JOURNAL_FORMAT;
+    f.close();
+    if (!ok) return false;
+    version = j[5];
+    strlcpy(lang, (const char*)j + 8, 16);
+    strlcpy(tier, (const char*)j + 24, 16);
+    return lang[0] && tier[0];
+}
+
+static void finishInstall() {
+    const char* lang = _languages[_dlLangIdx].id;
+    const char* tr = tierAt(_dlLangIdx, _dlTierIdx).id;
+
+    _progress = 98;
+    OsmosisSettings& s = settingsMgr.settings();
+    strlcpy(s.installedLang, lang, sizeof(s.installedLang));
+    strlcpy(s.installedTier, tr, sizeof(s.installedTier));
+    s.installedVer = tierAt(_dlLangIdx, _dlTierIdx).version;
+    s.progressIndex = 0;  // Reset progress for new pack
+    s.lastDay = 0;
+    settingsMgr.save();
+    SPIFFS.remove(JOURNAL_PATH);  // Only now is the pack installed
+
+    endInstall(PackDownloadState::Complete);
+    _progress = 100;
+    snprintf(_statusBuf, sizeof(_statusBuf), "%s ready!", _languages[_dlLangIdx].name);
+    Serial.printf("[pack] Install complete: %s %s\n", lang, tr);
+}
+
+static void beginInstall(uint8_t langIdx, uint8_t tierIdx) {
     _dlLangIdx = langIdx;
     _dlTierIdx = tierIdx;
+    snprintf(_dlPack, sizeof(_dlPack), "%s/%s", _languages[langIdx].id, tierAt(langIdx, tierIdx).id);
     _progress = 0;
     _emojiDone = 0;
     _emojiCount = 0;
-
-    const char* lang = _languages[langIdx].id;
-    const char* tr = _tiers[langIdx][tierIdx].id;
-
-    // Step 1: Download manifest.json
-    _state = PackDownloadState::FetchingManifest;
-    snprintf(_statusBuf, sizeof(_statusBuf), "Downloading %s...", _languages[langIdx].name);
-    _progress = 5;
+    _filesCleared = 0;
+    _attempt = 0;
+    _retrying = false;
+    _stats = {};
+    _stats.phase[(uint8_t)PackPhase::Catalog] = _catalogStats;
+    _stats.minFreeHeap = _stats.minMaxAlloc = UINT32_MAX;
+    sampleHeap();
+    _installStartMs = millis();
 
     Serial.printf("[pack] SPIFFS: %u used / %u total, free heap: %u\n",
                   (uint32_t)SPIFFS.usedBytes(), (uint32_t)SPIFFS.totalBytes(),
                   (uint32_t)ESP.getFreeHeap());
+    _oldPackIntact = packMgr::hasInstalledPack();  // Before the journal hides it
+    writeJournal();  // From here on a reboot resumes this pack
 
-    // Step 0: Wipe ALL old pack files to free SPIFFS space
-    // (SPIFFS becomes unreliable above ~75% usage due to GC issues)
-    {
-        strlcpy(_statusBuf, "Preparing storage...", sizeof(_statusBuf));
-        if (_progressCb) _progressCb();
-
-        // Delete files in small batches to avoid stack overflow
-        int totalDeleted = 0;
-        bool moreFiles = true;
-        while (moreFiles) {
-            moreFiles = false;
-            fs::File root = SPIFFS.open("/");
-            fs::File file = root.openNextFile();
-            // Collect a small batch
-            char batch[10][32];
-            int batchCount = 0;
-            while (file && batchCount < 10) {
-                const char* name = file.name();
-                if (name[0] == '/') {
-                    strlcpy(batch[batchCount], name, 32);
-                } else {
-                    batch[batchCount][0] = '/';
-                    strlcpy(batch[batchCount] + 1, name, 31);
-                }
-                batchCount++;
-                file.close();
-                file = root.openNextFile();
+    _step = DownloadStep::Prepare;
+    _state = PackDownloadState::PreparingStorage;
+    strlcpy(_statusBuf, "Preparing storage...", sizeof(_statusBuf));
+}
+
+static void transferEnded(bool ok);
+
+// Sends the request of the current step. One that can't be made (no
+// connection, HTTP error) ends as a failed transfer.
+static void startStepTransfer() {
+    const char* lang = _languages[_dlLangIdx].id;
+    const char* tr = tierAt(_dlLangIdx, _dlTierIdx).id;
+    char url[128];
+    char path[32];
+
+    switch (_step) {
+        case DownloadStep::Manifest:
+            snprintf(_statusBuf, sizeof(_statusBuf), "Downloading %s...", _languages[_dlLangIdx].name);
+            snprintf(url, sizeof(url), "%s/packs/%s/%s/manifest.json", BASE_URL, lang, tr);
+            strlcpy(path, "/manifest.json", sizeof(path));
+            endEmojiScan();  // A retry collects them from the start again
+            if (!beginEmojiScan()) {
+                failDownload("Out of memory");
+                return;
             }
-            if (file) { file.close(); moreFiles = true; }
-            // Delete this batch
-            for (int i = 0; i < batchCount; i++) {
-                SPIFFS.remove(batch[i]);
-                totalDeleted++;
+            break;
+        case DownloadStep::VocabPack:
+            // Binary copy of the manifest that loads without JSON parsing
+            snprintf(url, sizeof(url), "%s/packs/%s/%s/vocab.pack", BASE_URL, lang, tr);
+            strlcpy(path, "/vocab.pack", sizeof(path));
+            break;
+        case DownloadStep::AssetList:
+            snprintf(url, sizeof(url), "%s/packs/%s/%s/assets.idx", BASE_URL, lang, tr);
+            strlcpy(path, "/assets.idx", sizeof(path));
+            break;
+        case DownloadStep::Font:
+            strlcpy(_statusBuf, "Downloading font...", sizeof(_statusBuf));
+            snprintf(url, sizeof(url), "%s/packs/%s/font.vlw", BASE_URL, lang);
+            strlcpy(path, "/font.vlw", sizeof(path));
+            if (!beginTransfer(url, path, true)) transferEnded(false);
+            return;
+        case DownloadStep::EmojiBundle:
+            strlcpy(_statusBuf, "Downloading emoji...", sizeof(_statusBuf));
+            snprintf(url, sizeof(url), "%s/packs/%s/%s/emoji.bundle", BASE_URL, lang, tr);
+            if (!beginTransfer(url, nullptr)) transferEnded(false);
+            return;
+        case DownloadStep::Emoji: {
+            char name[20];
+            emojiFileName(_emojiDone, name, sizeof(name));
+            snprintf(url, sizeof(url), "%s/packs/emoji/%s", BASE_URL, name);
+            snprintf(path, sizeof(path), "/%s", name);
+            snprintf(_statusBuf, sizeof(_statusBuf), "Emoji %u/%u", _emojiDone + 1, _emojiTotal);
+            if (!beginTransfer(url, path, true)) transferEnded(false);
+            return;
+        }
+        default:
+            return;
+    }
+    if (!beginTransfer(url, path)) transferEnded(false);
+    else if (_step == DownloadStep::Manifest) _oldPackIntact = false;  // Now being overwritten
+}
+
+// Tries the current file again after a backoff if the failure may pass.
+// The bundle isn't retried: whatever it didn't deliver is fetched singly.
+static bool scheduleRetry() {
+    if (!_xfer.retryable || _step == DownloadStep::EmojiBundle) return false;
+    if (_attempt + 1 >= MAX_ATTEMPTS) return false;
+
+    uint32_t wait = RETRY_BASE_MS << _attempt;
+    _attempt++;
+    _stats.retries++;
+    _retrying = true;
+    _retryAtMs = millis() + wait;
+    snprintf(_statusBuf, sizeof(_statusBuf), "Retrying in %u s...", (unsigned)(wait / 1000));
+    Serial.printf("[pack] Attempt %u of %u in %u ms\n", _attempt + 1, MAX_ATTEMPTS, wait);
+    return true;
+}
+
+// Acts on the outcome of the current step's file
+static void transferEnded(bool ok) {
+    if (!ok && scheduleRetry()) return;
+    _attempt = 0;
+
+    switch (_step) {
+        case DownloadStep::Manifest:
+            if (!ok) {
+                failDownload("Manifest download failed");
+                return;
+            }
+            endEmojiScan();
+            _emojiTotal = _emojiCount;
+            _emojiDone = 0;
+            Serial.printf("[pack] Need %u unique emoji (%u dropped)\n", _emojiCount, _scan.dropped);
+            _progress = 5;
+            _step = DownloadStep::VocabPack;
+            startStepTransfer();
+            return;
+        case DownloadStep::VocabPack:
+            // Optional: packs built before vocab.pack existed only ship manifest.json
+            if (!ok) Serial.println("[pack] No vocab.pack, cards will load from manifest.json");
+            _progress = 10;
+            return;
+        case DownloadStep::AssetList:
+            // Optional: without it held files are matched by name only
+            if (!ok) {
+                Serial.println("[pack] No assets.idx, held files matched by name");
+                SPIFFS.remove("/assets.idx");  // Not the previous pack's
             }
-            if (batchCount > 0) moreFiles = true;  // Check for more
-            if (batchCount == 0) moreFiles = false;
-            yield();
+            _progress = 15;
+            _step = DownloadStep::Plan;
+            return;
+        case DownloadStep::Font:
+            if (!ok) {
+                failDownload("Font download failed");
+                return;
+            }
+            _progress = 25;
+            _step = DownloadStep::EmojiBundle;
+            return;
+        case DownloadStep::EmojiBundle:
+            // Whatever the bundle didn't deliver is fetched one by one
+            if (!ok) Serial.println("[pack] Emoji bundle incomplete, fetching the rest one by one");
+            _step = DownloadStep::Emoji;
+            return;
+        case DownloadStep::Emoji: {
+            // Continue despite individual failures
+            char name[20];
+            emojiFileName(_emojiDone, name, sizeof(name));
+            if (!ok) Serial.printf("[pack] Failed to download emoji %s\n", name);
+            _emojiDone++;
+            _progress = 25 + (_emojiDone * 65 / _emojiTotal);
+            return;
         }
-        Serial.printf("[pack] Cleared %d files, SPIFFS now: %u used / %u total\n",
-                      totalDeleted, (uint32_t)SPIFFS.usedBytes(), (uint32_t)SPIFFS.totalBytes());
+        default:
+            return;
     }
+}
+
+static void beginManifest() {
+    // Step 1: Download manifest.json, collecting its emoji on the way
     _progress = 3;
-    if (_progressCb) _progressCb();
+    _step = DownloadStep::Manifest;
+    _state = PackDownloadState::FetchingManifest;
+    startStepTransfer();
+}
+
+static void beginCatalogFetch(bool background);
+
+// Catalog position of the journalled pack, once the catalog is loaded.
+// Waits out Wi-Fi and catalog outages with a growing backoff.
+static void resumeStep() {
+    if (!wifiMgr::isConnected() || (int32_t)(millis() - _retryAtMs) < 0) return;
+    if (!_catalogLoaded) {
+        beginCatalogFetch(false);  // Failures set _retryAtMs, see catalogFetchEnded()
+        return;
+    }
+
+    for (uint8_t li = 0; li < _langCount; li++) {
+        if (strcmp(_languages[li].id, _resumeLang) != 0) continue;
+        for (uint8_t ti = 0; ti < tiersOf(li); ti++) {
+            if (strcmp(tierAt(li, ti).id, _resumeTier) != 0) continue;
+            if (tierAt(li, ti).version != _resumeVersion) {
+                // The files it got belong to another version: start over
+                Serial.printf("[pack] %s %s is now version %u, not %u: installing it afresh\n",
+                              _resumeLang, _resumeTier, tierAt(li, ti).version, _resumeVersion);
+                SPIFFS.remove("/manifest.json");
+                SPIFFS.remove("/vocab.pack");
+                SPIFFS.remove("/assets.idx");
+            }
+            beginInstall(li, ti);
+            return;
+        }
+    }
+
+    // Nothing to finish it with: drop the half-installed pack
+    Serial.printf("[pack] %s %s is no longer in the catalog\n", _resumeLang, _resumeTier);
+    SPIFFS.remove(JOURNAL_PATH);
+    SPIFFS.remove("/manifest.json");
+    SPIFFS.remove("/vocab.pack");
+    _step = DownloadStep::None;
+    _state = PackDownloadState::Error;
+    strlcpy(_statusBuf, "Pack no longer available", sizeof(_statusBuf));
+}
 
+// Replaces the tables with room for `langs` languages and `tiers` tiers in
+// all; false, with no catalog left, if the heap can't hold them
+static bool allocCatalog(uint8_t langs, uint16_t tiers) {
+    free(_languages);
+    free(_tiers);
+    free(_tierStart);
+    _languages = (CatalogLanguage*)calloc(langs ? langs : 1, sizeof(CatalogLanguage));
+    _tiers = (CatalogTier*)calloc(tiers ? tiers : 1, sizeof(CatalogTier));
+    _tierStart = (uint16_t*)calloc(langs + 1, sizeof(uint16_t));
+    _langCount = 0;
+    _catalogLoaded = false;
+    if (_languages && _tiers && _tierStart) return true;
+
+    Serial.printf("[pack] Out of memory for %u languages, %u tiers\n", langs, tiers);
+    free(_languages);
+    free(_tiers);
+    free(_tierStart);
+    _languages = nullptr;
+    _tiers = nullptr;
+    _tierStart = nullptr;
+    return false;
+}
+
+// Copies the parsed catalog into freshly sized tables
+static bool storeCatalog(JsonArray langs) {
+    uint16_t langTotal = 0, tierTotal = 0;
+    for (JsonObject lang : langs) {
+        if (langTotal == MAX_LANGUAGES) break;
+        JsonArray tiers = lang["tiers"];
+        size_t n = tiers.size() < MAX_TIERS ? tiers.size() : MAX_TIERS;
+        if (tierTotal + n > MAX_CATALOG_TIERS) break;
+        tierTotal += n;
+        langTotal++;
+    }
+    if (!allocCatalog(langTotal, tierTotal)) return false;
+
+    uint16_t ti = 0;
+    for (JsonObject lang : langs) {
+        if (_langCount == langTotal) break;
+        CatalogLanguage& l = _languages[_langCount];
+        strlcpy(l.id, lang["id"] | "", sizeof(l.id));
+        strlcpy(l.name, lang["name"] | "", sizeof(l.name));
+        strlcpy(l.flag, lang["flag"] | "", sizeof(l.flag));
+        _tierStart[_langCount] = ti;
+
+        JsonArray tiers = lang["tiers"];
+        for (JsonObject t : tiers) {
+            if (ti - _tierStart[_langCount] == MAX_TIERS) break;
+            CatalogTier& ct = _tiers[ti++];
+            strlcpy(ct.id, t["id"] | "", sizeof(ct.id));
+            strlcpy(ct.name, t["name"] | "", sizeof(ct.name));
+            ct.words = t["words"] | 0;
+            ct.version = t["version"] | 0;
+            ct.manifestSize = t["manifestSize"] | 0;
+            ct.fontSize = t["fontSize"] | 0;
+        }
+        _langCount++;
+    }
+    _tierStart[_langCount] = ti;
+    return true;
+}
+
+// GET of catalog.json on the kept-alive pack connection, so an install
+// started from the browser doesn't pay for another TLS handshake.
+// Conditional when the tables came from a response with validators.
+static int sendCatalogGet(const char* url) {
+    static const char* headerKeys[] = {"Transfer-Encoding", "ETag", "Last-Modified"};
+    HTTPClient& http = _xfer.http;
+    http.begin(_xfer.client, url);
+    http.setTimeout(10000);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    http.setReuse(true);
+    http.collectHeaders(headerKeys, 3);
+    if (_catalogLoaded && _catalogEtag[0]) http.addHeader("If-None-Match", _catalogEtag);
+    if (_catalogLoaded && _catalogModified[0]) http.addHeader("If-Modified-Since", _catalogModified);
+    return http.GET();
+}
+
+static void saveCatalogCache() {
+    fs::File f = SPIFFS.open(CATALOG_CACHE_TMP, "w");
+    if (!f) return;
+    uint16_t tiers = _tierStart[_langCount];
+    uint8_t header[8] = {'O', 'C', 'A', 'T', CATALOG_CACHE_FORMAT, _langCount,
+                         (uint8_t)tiers, (uint8_t)(tiers >> 8)};
+    size_t langBytes = _langCount * sizeof(CatalogLanguage);
+    size_t startBytes = (_langCount + 1) * sizeof(uint16_t);
+    size_t tierBytes = tiers * sizeof(CatalogTier);
+    bool ok = f.write(header, sizeof(header)) == sizeof(header) &&
+              f.write((const uint8_t*)_catalogEtag, sizeof(_catalogEtag)) == sizeof(_catalogEtag) &&
+              f.write((const uint8_t*)_catalogModified, sizeof(_catalogModified)) == sizeof(_catalogModified) &&
+              f.write((const uint8_t*)_languages, langBytes) == langBytes &&
+              f.write((const uint8_t*)_tierStart, startBytes) == startBytes &&
+              f.write((const uint8_t*)_tiers, tierBytes) == tierBytes;
+    f.close();
+    if (!ok) {
+        Serial.println("[pack] Failed to write catalog cache");
+        SPIFFS.remove(CATALOG_CACHE_TMP);
+        return;
+    }
+    SPIFFS.remove(CATALOG_CACHE_PATH);
+    SPIFFS.rename(CATALOG_CACHE_TMP, CATALOG_CACHE_PATH);
+}
+
+// Sends the conditional GET of a catalog fetch. A 304 ends it with the
+// tables kept; a 200 has its body written to CATALOG_BODY_PATH by pumpTransfer().
+static bool requestCatalog() {
     char url[128];
-    snprintf(url, sizeof(url), "%s/packs/%s/%s/manifest.json", BASE_URL, lang, tr);
-    if (!httpDownloadToSpiffs(url, "/manifest.json")) {
-        _state = PackDownloadState::Error;
-        strlcpy(_statusBuf, "Manifest download failed", sizeof(_statusBuf));
+    snprintf(url, sizeof(url), "%s/catalog.json", BASE_URL);
+    Serial.printf("[pack] Fetching: %s (heap: %u)\n", url, (uint32_t)ESP.getFreeHeap());
+    HTTPClient& http = _xfer.http;
+    _xfer.client.setInsecure();  // Skip TLS cert verification
+    bool reused = _xfer.client.connected();
+    int code = sendCatalogGet(url);
+    if (code < 0 && reused) {
+        closeConnection();  // Dropped while idle
+        code = sendCatalogGet(url);
+    }
+    Serial.printf("[pack] HTTP response: %d\n", code);
+
+    if (code == 304 && _catalogLoaded) {
+        http.end();
+        _catalogStats = {0, millis() - _catalogStartMs, 1};
+        _catalogStep = CatalogStep::None;
+        Serial.println("[pack] Catalog not modified");
+        return true;
+    }
+    if (code != 200) {
+        Serial.printf("[pack] Catalog fetch failed: HTTP %d\n", code);
+        closeConnection();
+        return false;
+    }
+    strlcpy(_bodyEtag, http.header("ETag").c_str(), sizeof(_bodyEtag));
+    strlcpy(_bodyModified, http.header("Last-Modified").c_str(), sizeof(_bodyModified));
+    _xfer.file = SPIFFS.open(CATALOG_BODY_PATH, "w");
+    if (!_xfer.file) {
+        Serial.printf("[pack] Failed to open %s for writing\n", CATALOG_BODY_PATH);
+        closeConnection();
         return false;
     }
-    _progress = 15;
-    if (_progressCb) _progressCb();
-    yield();
-    delay(100);
 
-    // Step 2: Download font.vlw
-    _state = PackDownloadState::FetchingFont;
-    strlcpy(_statusBuf, "Downloading font...", sizeof(_statusBuf));
+    _xfer.toBundle = false;
+    _xfer.toAsset = false;
+    _xfer.toCatalog = true;
+    _xfer.phase = PackPhase::Catalog;
+    _xfer.startMs = _catalogStartMs;
+    strlcpy(_xfer.path, CATALOG_BODY_PATH, sizeof(_xfer.path));
+    beginBody();
+    _xfer.lastDataMs = millis();
+    _xfer.active = true;
+    _catalogStep = CatalogStep::Body;
+    return true;
+}
 
-    snprintf(url, sizeof(url), "%s/packs/%s/font.vlw", BASE_URL, lang);
-    if (!httpDownloadToSpiffs(url, "/font.vlw")) {
-        _state = PackDownloadState::Error;
-        strlcpy(_statusBuf, "Font download failed", sizeof(_statusBuf));
+// The downloaded catalog.json into the tables. Read back from SPIFFS, so
+// only the filtered document is ever in RAM.
+static bool parseCatalogBody() {
+    fs::File f = SPIFFS.open(CATALOG_BODY_PATH, "r");
+    if (!f) return false;
+    JsonDocument filter;
+    deserializeJson(filter, CATALOG_FILTER);
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, f, DeserializationOption::Filter(filter));
+    f.close();
+    SPIFFS.remove(CATALOG_BODY_PATH);
+    if (err) {
+        Serial.printf("[pack] Catalog JSON error: %s\n", err.c_str());
         return false;
     }
-    _progress = 25;
-    if (_progressCb) _progressCb();
+    if (!storeCatalog(doc["languages"])) return false;
 
-    // Step 3: Parse manifest to get emoji list
-    fs::File f = SPIFFS.open("/manifest.json", "r");
-    if (!f) {
-        _state = PackDownloadState::Error;
+    _catalogLoaded = true;
+    _catalogRevision++;
+    strlcpy(_catalogEtag, _bodyEtag, sizeof(_catalogEtag));
+    strlcpy(_catalogModified, _bodyModified, sizeof(_catalogModified));
+    saveCatalogCache();
+    Serial.printf("[pack] Catalog loaded: %d languages\n", _langCount);
+    return true;
+}
+
+// Starts a catalog fetch; update() carries it on from the next call.
+// background: a failure keeps the tables and the state already shown.
+static void beginCatalogFetch(bool background) {
+    if (!_catalogLoaded) packMgr::loadCachedCatalog();  // For its validators
+    _catalogBackground = background;
+    _stateBefore = _state;
+    if (!background) {
+        _state = PackDownloadState::FetchingCatalog;
+        strlcpy(_statusBuf, "Fetching catalog...", sizeof(_statusBuf));
+    }
+    _catalogStartMs = millis();
+    _catalogStep = CatalogStep::Request;
+}
+
+// Drops a fetch still under way, before the connection is used for something else
+static void cancelCatalogFetch() {
+    if (_catalogStep == CatalogStep::None) return;
+    endTransfer(false);
+    _catalogStep = CatalogStep::None;
+    _state = _stateBefore;
+}
+
+static void catalogFetchEnded(bool ok) {
+    _catalogStep = CatalogStep::None;
+    if (_step == DownloadStep::Resume) {
+        // Waits out catalog outages with a growing backoff
+        _state = PackDownloadState::PreparingStorage;
+        if (ok) return;
+        uint32_t wait = RETRY_BASE_MS << _attempt;
+        if (_attempt < MAX_BACKOFF_SHIFT) _attempt++;
+        _retryAtMs = millis() + wait;
+        snprintf(_statusBuf, sizeof(_statusBuf), "Retrying in %u s...", (unsigned)(wait / 1000));
+    } else if (_catalogBackground) {
+        _state = _stateBefore;
+        if (!ok) Serial.println("[pack] Catalog refresh failed, keeping the catalog");
+    } else {
+        _state = ok ? PackDownloadState::Idle : PackDownloadState::Error;
+        if (!ok) strlcpy(_statusBuf, "Catalog fetch failed", sizeof(_statusBuf));
+    }
+}
+
+// One bounded piece of the catalog fetch
+static void catalogStep() {
+    bool ok = true;
+    switch (_catalogStep) {
+        case CatalogStep::Request:
+            ok = requestCatalog();
+            break;
+        case CatalogStep::Body: {
+            TransferResult r = pumpTransfer();
+            if (r == TransferResult::Pending) return;
+            ok = (r == TransferResult::Done);
+            _catalogStats = {_xfer.received, millis() - _catalogStartMs, 1};
+            endTransfer(ok);  // Drops the partial file on a failure
+            _catalogStep = CatalogStep::Parse;
+            break;
+        }
+        case CatalogStep::Parse:
+            ok = parseCatalogBody();
+            _catalogStep = CatalogStep::None;
+            break;
+        default:
+            return;
+    }
+    if (!ok || _catalogStep == CatalogStep::None) catalogFetchEnded(ok);
+}
+
+// A device that only ever took OTA updates keeps the partition table it was
+// first flashed with, without the assets partition: nothing can be written
+// until it is flashed over USB, so say that instead of failing every file
+static bool assetsPartitionFound() {
+    if (assetStore::totalBytes() > 0) return true;
+    Serial.println("[pack] No assets partition, flash the firmware over USB");
+    _state = PackDownloadState::Error;
+    strlcpy(_statusBuf, "No assets partition: reflash via USB", sizeof(_statusBuf));
+    return false;
+}
+
+namespace packMgr {
+
+bool fetchCatalog() {
+    if (!wifiMgr::isConnected()) {
+        Serial.println("[pack] WiFi not connected");
         return false;
     }
+    if (_step != DownloadStep::None) return false;  // The connection is busy with a pack
+    if (_catalogStep != CatalogStep::None) {
+        // A refresh under way becomes this fetch
+        _catalogBackground = false;
+        _state = PackDownloadState::FetchingCatalog;
+        strlcpy(_statusBuf, "Fetching catalog...", sizeof(_statusBuf));
+        return true;
+    }
+    beginCatalogFetch(false);
+    return true;
+}
 
-    JsonDocument doc;
-    deserializeJson(doc, f);
+bool loadCachedCatalog() {
+    fs::File f = SPIFFS.open(CATALOG_CACHE_PATH, "r");
+    if (!f) return false;
+    uint8_t header[8];
+    bool ok = f.read(header, sizeof(header)) == sizeof(header) &&
+              memcmp(header, "OCAT", 4) == 0 && header[4] == CATALOG_CACHE_FORMAT &&
+              f.read((uint8_t*)_catalogEtag, sizeof(_catalogEtag)) == sizeof(_catalogEtag) &&
+              f.read((uint8_t*)_catalogModified, sizeof(_catalogModified)) == sizeof(_catalogModified);
+    uint8_t langs = ok ? header[5] : 0;
+    uint16_t tiers = ok ? header[6] | (header[7] << 8) : 0;
+    ok = ok && tiers <= MAX_CATALOG_TIERS && allocCatalog(langs, tiers);
+    if (ok) {
+        size_t langBytes = langs * sizeof(CatalogLanguage);
+        size_t startBytes = (langs + 1) * sizeof(uint16_t);
+        size_t tierBytes = tiers * sizeof(CatalogTier);
+        ok = f.read((uint8_t*)_languages, langBytes) == langBytes &&
+             f.read((uint8_t*)_tierStart, startBytes) == startBytes &&
+             f.read((uint8_t*)_tiers, tierBytes) == tierBytes && _tierStart[0] == 0 &&
+             _tierStart[langs] == tiers;
+        for (uint8_t li = 0; ok && li < langs; li++) ok = _tierStart[li] <= _tierStart[li + 1];
+    }
     f.close();
 
-    JsonArray wordsArr = doc["words"];
-    _emojiCount = 0;
-    for (JsonObject w : wordsArr) {
-        if (_emojiCount >= MAX_EMOJI) break;
-        const char* em = w["emoji"] | "";
-        if (strlen(em) > 0) {
-            strlcpy(_emojiList[_emojiCount], em, sizeof(_emojiList[0]));
-            _emojiCount++;
+    _catalogEtag[sizeof(_catalogEtag) - 1] = '\0';
+    _catalogModified[sizeof(_catalogModified) - 1] = '\0';
+    if (!ok) {
+        Serial.println("[pack] Catalog cache unreadable");
+        _catalogEtag[0] = _catalogModified[0] = '\0';
+        allocCatalog(0, 0);
+        return false;
+    }
+    _langCount = langs;
+    _catalogLoaded = true;
+    _catalogRevision++;
+    Serial.printf("[pack] Catalog cache: %u languages, ETag %s\n", _langCount, _catalogEtag);
+    return true;
+}
+
+void refreshCatalog() {
+    _refreshPending = true;
+}
+
+bool fetchingCatalog() { return _catalogStep != CatalogStep::None; }
+uint8_t catalogRevision() { return _catalogRevision; }
+
+uint8_t languageCount() { return _langCount; }
+const CatalogLanguage& language(uint8_t i) { return _languages[i]; }
+uint8_t tierCount(uint8_t langIdx) { return tiersOf(langIdx); }
+const CatalogTier& tier(uint8_t langIdx, uint8_t tierIdx) { return tierAt(langIdx, tierIdx); }
+
+bool startDownload(uint8_t langIdx, uint8_t tierIdx) {
+    if (!wifiMgr::isConnected() || !_catalogLoaded) return false;
+    if (langIdx >= _langCount || tierIdx >= tiersOf(langIdx)) return false;
+    if (_step != DownloadStep::None) return false;  // Already downloading
+    if (!assetsPartitionFound()) return false;
+
+    cancelCatalogFetch();  // Could replace the tables langIdx and tierIdx index
+    beginInstall(langIdx, tierIdx);
+    return true;
+}
+
+bool hasPendingInstall() {
+    return readJournal(_resumeLang, _resumeTier, _resumeVersion);
+}
+
+bool resumeDownload() {
+    if (_step != DownloadStep::None) return false;
+    if (!readJournal(_resumeLang, _resumeTier, _resumeVersion)) return false;
+    if (!assetsPartitionFound()) return false;
+
+    cancelCatalogFetch();
+    Serial.printf("[pack] Resuming install of %s %s\n", _resumeLang, _resumeTier);
+    _oldPackIntact = false;  // What is on SPIFFS is the unfinished install
+    _progress = 0;
+    _attempt = 0;
+    _retryAtMs = millis();
+    _step = DownloadStep::Resume;
+    _state = PackDownloadState::PreparingStorage;
+    strlcpy(_statusBuf, "Waiting for WiFi...", sizeof(_statusBuf));
+    return true;
+}
+
+void update() {
+    // Catalog fetch, one piece per call like the install
+    if (_catalogStep != CatalogStep::None) {
+        catalogStep();
+        return;
+    }
+    if (_step == DownloadStep::None) {
+        if (_refreshPending && wifiMgr::isConnected()) {
+            _refreshPending = false;
+            beginCatalogFetch(true);
         }
+        return;
     }
+    sampleHeap();
 
-    // Deduplicate emoji list
-    uint16_t unique = 0;
-    for (uint16_t i = 0; i < _emojiCount; i++) {
-        bool dup = false;
-        for (uint16_t j = 0; j < unique; j++) {
-            if (strcmp(_emojiList[i], _emojiList[j]) == 0) {
-                dup = true;
-                break;
+    // A file is streaming: move the next chunk, then act on the step's outcome
+    if (_xfer.active) {
+        TransferResult r = pumpTransfer();
+        if (r == TransferResult::Pending) {
+            if (_xfer.toBundle && _bundle.index && _bundle.count) {
+                _progress = 25 + (_bundle.entry * 65 / _bundle.count);
+                snprintf(_statusBuf, sizeof(_statusBuf), "Emoji %u/%u", _bundle.entry + 1, _bundle.count);
             }
+            return;
+        }
+        bool ok = (r == TransferResult::Done);
+        if (ok && _xfer.toBundle && !bundleComplete()) {
+            Serial.printf("[pack] Emoji bundle ended after %u of %u images\n",
+                          _bundle.entry, _bundle.count);
+            ok = false;
         }
-        if (!dup) {
-            if (unique != i) strlcpy(_emojiList[unique], _emojiList[i], sizeof(_emojiList[0]));
-            unique++;
+        // A whole body that doesn't match assets.idx leaves the connection
+        // usable: only the file goes, and it is fetched again
+        bool intact = !ok || _xfer.toBundle || contentIntact(_xfer.path + 1, _xfer.received, _xfer.crc);
+        if (_xfer.toAsset && ok && intact) assetStore::commitWrite();
+        endTransfer(ok);
+        if (!intact) {
+            if (!_xfer.toAsset) SPIFFS.remove(_xfer.path);
+            _xfer.retryable = true;
+            ok = false;
         }
+        transferEnded(ok);
+        return;
     }
-    _emojiCount = unique;
-    _emojiTotal = _emojiCount;
-    _emojiDone = 0;
 
-    Serial.printf("[pack] Need %u unique emoji\n", _emojiCount);
+    // A file failed and waits for its next attempt. Time without Wi-Fi
+    // doesn't use attempts up.
+    if (_retrying) {
+        if ((int32_t)(millis() - _retryAtMs) < 0) return;
+        if (!wifiMgr::isConnected()) {
+            _retryAtMs = millis() + RETRY_BASE_MS;
+            return;
+        }
+        _retrying = false;
+        startStepTransfer();
+        return;
+    }
 
-    // Step 4: Download emoji (skip existing)
-    _state = PackDownloadState::FetchingEmoji;
-    for (uint16_t i = 0; i < _emojiCount; i++) {
-        char binPath[32];
-        snprintf(binPath, sizeof(binPath), "/%s.bin", _emojiList[i]);
+    switch (_step) {
+        case DownloadStep::Resume:
+            resumeStep();
+            return;
 
-        // Skip if already on SPIFFS
-        if (SPIFFS.exists(binPath)) {
-            _emojiDone++;
-            _progress = 25 + (_emojiDone * 65 / _emojiTotal);
-            continue;
+        case DownloadStep::Prepare: {
+            // Step 0: Find out what is already here. A device without an
+            // inventory holds files nothing tracks, so it starts empty.
+            bool held = assetStore::load();
+            assetStore::beginInstall();
+            if (held) {
+                beginManifest();
+            } else {
+                _oldPackIntact = false;
+                _step = DownloadStep::WipeStorage;
+            }
+            return;
         }
 
-        snprintf(_statusBuf, sizeof(_statusBuf), "Emoji %u/%u", _emojiDone + 1, _emojiTotal);
-        snprintf(url, sizeof(url), "%s/packs/emoji/%s.bin", BASE_URL, _emojiList[i]);
+        case DownloadStep::WipeStorage:
+            if (!wipeBatch()) return;
+            Serial.printf("[pack] Cleared %u files, SPIFFS now: %u used / %u total\n",
+                          _filesCleared, (uint32_t)SPIFFS.usedBytes(),
+                          (uint32_t)SPIFFS.totalBytes());
+            assetStore::save();  // Empty, so a resumed install knows nothing untracked is left
+            beginManifest();
+            return;
 
-        if (!httpDownloadToSpiffs(url, binPath)) {
-            Serial.printf("[pack] Failed to download emoji %s\n", _emojiList[i]);
-            // Continue despite individual failures
+        case DownloadStep::VocabPack:
+            // Step 2: Sizes and hashes of the font and emoji
+            _step = DownloadStep::AssetList;
+            startStepTransfer();
+            return;
+
+        case DownloadStep::Plan:
+            // Step 3: Compare the manifest's emoji with what's held
+            planInstall();
+            _step = DownloadStep::MakeRoom;
+            return;
+
+        case DownloadStep::MakeRoom: {
+            size_t budget = storageBudget();
+            size_t target = _missingBytes < budget ? budget - _missingBytes : 0;
+            if (!assetStore::collectGarbage(target, WIPE_BATCH)) return;
+
+            // Step 4: Download font.vlw if the held one is another language's
+            _progress = 20;
+            _step = DownloadStep::EmojiBundle;
+            if (!_fontNeeded) return;
+            _step = DownloadStep::Font;
+            _state = PackDownloadState::FetchingFont;
+            startStepTransfer();
+            return;
         }
 
-        _emojiDone++;
-        _progress = 25 + (_emojiDone * 65 / _emojiTotal);
-        if (_progressCb) _progressCb();
-        yield();  // Let WiFi stack breathe
-    }
+        case DownloadStep::EmojiBundle:
+            // Step 5: The missing emoji in one request, if enough are missing.
+            // Optional: without a bundle every emoji is its own request
+            _state = PackDownloadState::FetchingEmoji;
+            _step = DownloadStep::Emoji;
+            if (!bundleWorthIt()) return;
+            _step = DownloadStep::EmojiBundle;
+            startStepTransfer();
+            return;
 
-    // Step 5: No orphan cleanup needed — we wiped all files at start
+        case DownloadStep::Emoji:
+            // Step 6: Download emoji the bundle didn't cover (skip held ones)
+            if (nextMissingEmoji()) {
+                if (_emojiTotal) _progress = 25 + (_emojiDone * 65 / _emojiTotal);
+                startStepTransfer();
+                return;
+            }
+            _step = DownloadStep::Collect;
+            return;
 
-    // Step 6: Update settings
-    _progress = 98;
-    OsmosisSettings& s = settingsMgr.settings();
-    strlcpy(s.installedLang, lang, sizeof(s.installedLang));
-    strlcpy(s.installedTier, tr, sizeof(s.installedTier));
-    s.installedVer = _tiers[langIdx][tierIdx].version;
-    s.progressIndex = 0;  // Reset progress for new pack
-    s.lastDay = 0;
-    settingsMgr.save();
+        case DownloadStep::Collect:
+            // Step 7: Files no longer used stay as a cache within the budget
+            _progress = 95;
+            if (!assetStore::collectGarbage(storageBudget(), WIPE_BATCH)) return;
+            _step = DownloadStep::Finish;
+            return;
 
-    _state = PackDownloadState::Complete;
-    _progress = 100;
-    snprintf(_statusBuf, sizeof(_statusBuf), "%s ready!", _languages[langIdx].name);
-    Serial.printf("[pack] Install complete: %s %s\n", lang, tr);
-    return true;
+        case DownloadStep::Finish:
+            // Step 8: Update settings
+            finishInstall();
+            return;
+
+        default:
+            return;
+    }
 }
 
-void update() {
-    // Currently downloads are synchronous in startDownload()
-    // Placeholder for future async download support
+void cancelDownload() {
+    if (_step == DownloadStep::None) return;
+    // Until storage is wiped or the manifest overwritten, the pack installed
+    // before is untouched and stays in use
+    bool keepPack = _oldPackIntact;
+    cancelCatalogFetch();  // Of a resume
+    endTransfer(false);  // Drops the partial file
+    endInstall(PackDownloadState::Cancelled);
+
+    // Without a manifest the half-installed pack is not picked up at boot,
+    // and without the journal it isn't resumed either
+    if (!keepPack) {
+        SPIFFS.remove("/manifest.json");
+        SPIFFS.remove("/vocab.pack");
+    }
+    SPIFFS.remove(JOURNAL_PATH);
+
+    strlcpy(_statusBuf, "Download cancelled", sizeof(_statusBuf));
+    Serial.println("[pack] Download cancelled");
 }
 
 PackDownloadState state() { return _state; }
+const PackInstallStats& installStats() { return _stats; }
+
+size_t installStatsJson(char* buf, size_t len) {
+    static const char* PHASE_NAMES[] = {"catalog", "manifest", "font", "emoji"};
+    const char* result = _state == PackDownloadState::Complete  ? "complete"
+                         : _state == PackDownloadState::Error     ? "error"
+                         : _state == PackDownloadState::Cancelled ? "cancelled"
+                                                                  : "running";
+    size_t pos = 0;
+    appendf(buf, len, pos,
+            "{\"pack\":\"%s\",\"result\":\"%s\",\"ms\":%u,\"bytes\":%u,\"requests\":%u,"
+            "\"handshakes\":%u,\"retries\":%u,\"rejected\":%u,\"connect_ms\":%u,\"phases\":{",
+            _dlPack, result, _stats.ms,
+            _stats.bytes, _stats.requests, _stats.handshakes, _stats.retries, _stats.rejected,
+            _stats.connectMs);
+    for (uint8_t i = 0; i < (uint8_t)PackPhase::Count; i++) {
+        const PackPhaseStats& p = _stats.phase[i];
+        appendf(buf, len, pos, "%s\"%s\":{\"bytes\":%u,\"ms\":%u,\"files\":%u}", i ? "," : "",
+                PHASE_NAMES[i], p.bytes, p.ms, p.files);
+    }
+    appendf(buf, len, pos, "},\"latency_ms\":[");
+    for (uint8_t i = 0; i < PACK_LATENCY_BUCKETS - 1; i++) {
+        appendf(buf, len, pos, "%s%u", i ? "," : "", PACK_LATENCY_MS[i]);
+    }
+    appendf(buf, len, pos, "],\"latency_files\":[");
+    for (uint8_t i = 0; i < PACK_LATENCY_BUCKETS; i++) {
+        appendf(buf, len, pos, "%s%u", i ? "," : "", _stats.latency[i]);
+    }
+    appendf(buf, len, pos, "],\"min_free_heap\":%u,\"min_max_alloc\":%u}", _stats.minFreeHeap,
+            _stats.minMaxAlloc);
+    return pos;
+}
 uint8_t progressPercent() { return _progress; }
 const char* statusText() { return _statusBuf; }
 
@@ -354,10 +1666,9 @@ void resetState() {
     _statusBuf[0] = '\0';
 }
 
-void setProgressCallback(ProgressCallback cb) { _progressCb = cb; }
-
 bool hasInstalledPack() {
-    return SPIFFS.exists("/manifest.json");
+    // A journal means the manifest may belong to an install that never finished
+    return SPIFFS.exists("/manifest.json") && !SPIFFS.exists(JOURNAL_PATH);
 }
 
 }  // namespace packMgr
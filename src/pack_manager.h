@@ -1,15 +1,18 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 enum class PackDownloadState : uint8_t {
     Idle,
     FetchingCatalog,
+    PreparingStorage,
     FetchingManifest,
     FetchingFont,
     FetchingEmoji,
     CleaningOrphans,
     Complete,
-    Error
+    Error,
+    Cancelled
 };
 
 struct CatalogLanguage {
@@ -27,28 +30,65 @@ struct CatalogTier {
     uint32_t fontSize;
 };
 
+// Where install bytes and time go; PackInstallStats::phase is indexed by these
+enum class PackPhase : uint8_t { Catalog, Manifest, Font, Emoji, Count };
+
+struct PackPhaseStats {
+    uint32_t bytes;
+    uint32_t ms;          // Summed over the phase's transfers, request to last byte
+    uint16_t files;       // Transfers (an emoji bundle counts once)
+};
+
+// Upper bounds of the per-file latency buckets; the last bucket is open-ended
+static const uint8_t PACK_LATENCY_BUCKETS = 8;
+static const uint16_t PACK_LATENCY_MS[PACK_LATENCY_BUCKETS - 1] = {50, 100, 250, 500, 1000, 2500, 5000};
+
+// Cost of the last install, final once it leaves the download states. The
+// catalog phase is the catalog fetch that preceded it (no bytes if it got a 304).
+struct PackInstallStats {
+    uint16_t requests;
+    uint16_t handshakes;  // TLS connections opened (one per install unless the server drops it)
+    uint16_t retries;     // Requests sent again: dropped keep-alive connection or backoff after a failure
+    uint16_t rejected;    // Files that didn't match their assets.idx hash and were dropped
+    uint32_t bytes;       // Response bodies written to SPIFFS
+    uint32_t ms;          // startDownload() to Complete/Error/Cancelled
+    uint32_t connectMs;   // Spent in requests that had to open a connection first
+    PackPhaseStats phase[(uint8_t)PackPhase::Count];
+    uint16_t latency[PACK_LATENCY_BUCKETS];  // Transfers by request-to-last-byte time
+    uint32_t minFreeHeap;
+    uint32_t minMaxAlloc; // Smallest "largest free block" seen
+};
+
 namespace packMgr {
     // Catalog
-    bool fetchCatalog();                        // Download catalog.json
+    bool fetchCatalog();                        // Start downloading catalog.json (conditional, cached on SPIFFS)
+    bool loadCachedCatalog();                   // Last fetched catalog, without a request
+    void refreshCatalog();                      // Conditional fetch over the next idle update() calls with Wi-Fi
+    bool fetchingCatalog();                     // A fetch or refresh is under way: keep calling update()
+    uint8_t catalogRevision();                  // Changes whenever the tables are replaced
     uint8_t languageCount();
     const CatalogLanguage& language(uint8_t i);
     uint8_t tierCount(uint8_t langIdx);
     const CatalogTier& tier(uint8_t langIdx, uint8_t tierIdx);
 
-    // Download
+    // Download (non-blocking: startDownload() only queues it, update() advances it)
     bool startDownload(uint8_t langIdx, uint8_t tierIdx);
-    void update();                              // Call in loop() during download
+    void update();                              // Call in loop() during download or refresh, one bounded step
+    void cancelDownload();                      // Abort, drop partial files -> Cancelled
+
+    // An install interrupted by a reboot is journalled on SPIFFS and picked
+    // up where it stopped; files it already downloaded are not fetched again
+    bool hasPendingInstall();
+    bool resumeDownload();                      // Queue it; waits for Wi-Fi and the catalog
     PackDownloadState state();
     uint8_t progressPercent();                  // 0-100
     const char* statusText();                   // Human-readable status
+    const PackInstallStats& installStats();
+    size_t installStatsJson(char* buf, size_t len);  // One-line JSON record, as logged
 
     // State management
-    void resetState();                          // Reset to Idle (after handling Complete/Error)
+    void resetState();                          // Reset to Idle (after handling Complete/Error/Cancelled)
 
     // Installed pack
-    bool hasInstalledPack();
-
-    // Progress callback — called during download to allow UI redraw
-    typedef void (*ProgressCallback)();
-    void setProgressCallback(ProgressCallback cb);
+    bool hasInstalledPack();                    // false while an install is pending
 }
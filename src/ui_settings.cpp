@@ -1,5 +1,6 @@
 #include "ui_settings.h"
 #include "display_manager.h"
+#include "dirty_region.h"
 #include "settings_manager.h"
 #include "wifi_manager.h"
 #include "pack_manager.h"
@@ -55,6 +56,10 @@ static const int LANG_Y = 234;
 static const int LANG_W = 200;
 static const int LANG_H = 36;
 
+// --- WiFi status line (font 1) ---
+static const int WIFI_STATUS_Y = 274;
+static const int WIFI_STATUS_H = 8;
+
 // --- Bottom row: WiFi + Close side by side ---
 static const int BOTTOM_Y = 286;
 static const int BOTTOM_H = 26;
@@ -63,6 +68,31 @@ static const int WIFI_W = 105;
 static const int CLOSE_X = 125;
 static const int CLOSE_W = 105;
 
+// --- Language browser ---
+static const int LANGS_PER_PAGE = 6;
+
+// --- Download progress page ---
+static const int PROGRESS_BAR_Y = 140;
+static const int PROGRESS_BAR_H = 20;
+static const int PERCENT_Y      = 170;  // Font 4
+static const int PERCENT_H      = 26;
+static const int STATUS_Y       = 210;  // Font 2
+static const int STATUS_H       = 16;
+
+// Two lines from the last install's metrics (the full record goes to serial)
+static void drawInstallStats(TFT_eSPI& tft, int y) {
+    const PackInstallStats& st = packMgr::installStats();
+    char line[48];
+    tft.setTextDatum(TC_DATUM);
+    tft.setTextColor(CLR_TEXT_SECONDARY);
+    snprintf(line, sizeof(line), "%u KB, %u.%u s, %u req, %u TLS", (unsigned)(st.bytes / 1024),
+             (unsigned)(st.ms / 1000), (unsigned)(st.ms % 1000 / 100), st.requests, st.handshakes);
+    tft.drawString(line, SCREEN_W / 2, y, 2);
+    snprintf(line, sizeof(line), "Heap min %u KB, block %u KB", (unsigned)(st.minFreeHeap / 1024),
+             (unsigned)(st.minMaxAlloc / 1024));
+    tft.drawString(line, SCREEN_W / 2, y + 18, 2);
+}
+
 // -------------------------------------------------------
 void SettingsScreen::show() {
     _active = true;
@@ -75,6 +105,13 @@ void SettingsScreen::hide() {
     _page = SettingsPage::Main;
 }
 
+void SettingsScreen::resumeDownload() {
+    _active = true;
+    _selectedLang = -1;
+    _page = SettingsPage::DownloadProgress;
+    if (!packMgr::resumeDownload()) showDownloadStopped("Download Failed", false);
+}
+
 // -------------------------------------------------------
 bool SettingsScreen::hitTest(const Button& btn, TouchPoint pt) {
     bool hit = pt.x >= btn.x && pt.x < btn.x + btn.w &&
@@ -86,17 +123,89 @@ bool SettingsScreen::hitTest(const Button& btn, TouchPoint pt) {
     return hit;
 }
 
+// -------------------------------------------------------
+bool SettingsScreen::pressActive() const {
+    return _pressedMs > 0 && (millis() - _pressedMs < PRESS_FLASH_MS);
+}
+
 // -------------------------------------------------------
 void SettingsScreen::flashPress() {
     // Immediately render screen to show the blue pressed button
-    TFT_eSprite& spr = display.getStrip();
+    render();
+    delay(120);
+}
+
+// -------------------------------------------------------
+void SettingsScreen::markChanges() {
+    dirtyRegion.beginFrame(ScreenId::Settings);
+
+    const OsmosisSettings& s = settingsMgr.settings();
+    DrawnState now = {};
+    now.page         = _page;
+    now.selectedLang = _selectedLang;
+    now.scrollOffset = _scrollOffset;
+    now.langCount    = packMgr::languageCount();
+    now.catalogRev   = packMgr::catalogRevision();
+    now.wordsPerDay  = s.wordsPerDay;
+    now.displaySecs  = s.displaySecs;
+    now.brightness   = s.brightness;
+    now.showPhonetic = s.showPhonetic;
+    now.wifiState    = (uint8_t)wifiMgr::state();
+    strlcpy(now.ssid, wifiMgr::ssid(), sizeof(now.ssid));
+    now.progress     = packMgr::progressPercent();
+    now.pressed      = pressActive();
+    now.pressedBtn   = _pressedBtn;
+    strlcpy(now.status, packMgr::statusText(), sizeof(now.status));
+
+    if (now.page != _drawn.page || now.selectedLang != _drawn.selectedLang ||
+        now.scrollOffset != _drawn.scrollOffset || now.langCount != _drawn.langCount ||
+        now.catalogRev != _drawn.catalogRev) {
+        dirtyRegion.markAll();
+    } else if (_page == SettingsPage::Main) {
+        if (now.wordsPerDay != _drawn.wordsPerDay)   dirtyRegion.mark(WPD_Y, WPD_H);
+        if (now.displaySecs != _drawn.displaySecs)   dirtyRegion.mark(DT_Y, DT_H);
+        if (now.brightness != _drawn.brightness)     dirtyRegion.mark(BR_Y, BR_H);
+        if (now.showPhonetic != _drawn.showPhonetic) dirtyRegion.mark(PH_Y, PH_H);
+        if (now.wifiState != _drawn.wifiState || strcmp(now.ssid, _drawn.ssid) != 0) {
+            dirtyRegion.mark(WIFI_STATUS_Y, WIFI_STATUS_H);
+        }
+    } else if (_page == SettingsPage::LanguageBrowser) {
+        // Status text and Retry button depend on Wi-Fi state
+        if (now.wifiState != _drawn.wifiState) dirtyRegion.markAll();
+    } else if (_page == SettingsPage::DownloadProgress) {
+        if (now.progress != _drawn.progress) {
+            dirtyRegion.mark(PROGRESS_BAR_Y, PROGRESS_BAR_H);
+            dirtyRegion.mark(PERCENT_Y, PERCENT_H);
+        }
+        if (strcmp(now.status, _drawn.status) != 0) dirtyRegion.mark(STATUS_Y, STATUS_H);
+    }
+
+    // Pressed-button flash: repaint the old and new button on any change
+    const Button& a = _drawn.pressedBtn;
+    const Button& b = now.pressedBtn;
+    bool moved = a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h;
+    if (now.pressed != _drawn.pressed || moved) {
+        if (_drawn.pressed) dirtyRegion.mark(a.y, a.h);
+        if (now.pressed)    dirtyRegion.mark(b.y, b.h);
+    }
+
+    _drawn = now;
+}
+
+// -------------------------------------------------------
+void SettingsScreen::render() {
+    markChanges();
+
     for (int strip = 0; strip < NUM_STRIPS; strip++) {
         int sy = strip * STRIP_H;
+        if (!dirtyRegion.needsStrip(sy)) continue;
+        TFT_eSprite& spr = display.getStrip();  // Alternates between DMA buffers
         spr.fillSprite(CLR_BG_DARK);
         draw(spr, sy);
         display.pushStrip(sy);
     }
-    delay(120);
+    display.waitStrips();
+    dirtyRegion.endFrame();
 }
 
 // -------------------------------------------------------
@@ -115,7 +224,7 @@ void SettingsScreen::drawButton(TFT_eSprite& spr, const Button& btn,
     if (drawY + drawH > STRIP_H) { drawH = STRIP_H - drawY; }
 
     // Check if this button is currently "pressed" (flash feedback)
-    bool pressed = (_pressedMs > 0 && (millis() - _pressedMs < PRESS_FLASH_MS) &&
+    bool pressed = (pressActive() &&
                     btn.x == _pressedBtn.x && btn.y == _pressedBtn.y &&
                     btn.w == _pressedBtn.w && btn.h == _pressedBtn.h);
 
@@ -242,8 +351,8 @@ void SettingsScreen::drawMainPage(TFT_eSprite& spr, int stripY) {
 
     // WiFi status line
     {
-        int y = 274 - stripY;
-        if (y >= -8 && y < STRIP_H) {
+        int y = WIFI_STATUS_Y - stripY;
+        if (y >= -WIFI_STATUS_H && y < STRIP_H) {
             spr.setTextDatum(TC_DATUM);
             WiFiState ws = wifiMgr::state();
             if (wifiMgr::isConnected()) {
@@ -339,7 +448,6 @@ void SettingsScreen::drawLanguageBrowser(TFT_eSprite& spr, int stripY) {
 
     if (_selectedLang < 0) {
         // Show language list with pagination (6 per page)
-        const int LANGS_PER_PAGE = 6;
         int startIdx = _scrollOffset * LANGS_PER_PAGE;
         int endIdx = startIdx + LANGS_PER_PAGE;
         if (endIdx > count) endIdx = count;
@@ -356,7 +464,7 @@ void SettingsScreen::drawLanguageBrowser(TFT_eSprite& spr, int stripY) {
         if (totalPages > 1) {
             int y = 280 - stripY;
             if (y >= -8 && y < STRIP_H) {
-                char pgBuf[8];
+                char pgBuf[12];
                 snprintf(pgBuf, sizeof(pgBuf), "%d/%d", _scrollOffset + 1, totalPages);
                 spr.setTextColor(CLR_TEXT_DIM, CLR_BG_DARK);
                 spr.setTextDatum(TC_DATUM);
@@ -423,9 +531,9 @@ void SettingsScreen::drawDownloadProgress(TFT_eSprite& spr, int stripY) {
     // Progress bar outline (200x20, centered)
     {
         int barX = 20;
-        int barY = 140;
+        int barY = PROGRESS_BAR_Y;
         int barW = 200;
-        int barH = 20;
+        int barH = PROGRESS_BAR_H;
         int barBottom = barY + barH;
 
         if (barBottom > stripY && barY < stripY + STRIP_H) {
@@ -455,8 +563,8 @@ void SettingsScreen::drawDownloadProgress(TFT_eSprite& spr, int stripY) {
 
     // Percentage text
     {
-        int y = 170 - stripY;
-        if (y >= -16 && y < STRIP_H) {
+        int y = PERCENT_Y - stripY;
+        if (y >= -PERCENT_H && y < STRIP_H) {
             char buf[8];
             snprintf(buf, sizeof(buf), "%u%%", pct);
             spr.setTextColor(CLR_TEXT_PRIMARY, CLR_BG_DARK);
@@ -467,13 +575,16 @@ void SettingsScreen::drawDownloadProgress(TFT_eSprite& spr, int stripY) {
 
     // Status message
     {
-        int y = 210 - stripY;
-        if (y >= -16 && y < STRIP_H) {
+        int y = STATUS_Y - stripY;
+        if (y >= -STATUS_H && y < STRIP_H) {
             spr.setTextColor(CLR_TEXT_SECONDARY, CLR_BG_DARK);
             spr.setTextDatum(TC_DATUM);
             spr.drawString(packMgr::statusText(), SCREEN_W / 2, y, 2);
         }
     }
+
+    Button cancel = {60, 260, 120, 30};
+    drawButton(spr, cancel, stripY, "CANCEL", false);
 }
 
 // -------------------------------------------------------
@@ -483,12 +594,84 @@ bool SettingsScreen::handleTap(TouchPoint pt) {
             return handleMainTap(pt);
         case SettingsPage::LanguageBrowser:
             return handleBrowserTap(pt);
-        case SettingsPage::DownloadProgress:
-            return false;  // No touch during download
+        case SettingsPage::DownloadProgress: {
+            Button cancel = {60, 260, 120, 30};
+            if (hitTest(cancel, pt)) {
+                flashPress();
+                packMgr::cancelDownload();  // update() then returns to the browser
+                return true;
+            }
+            return false;
+        }
     }
     return false;
 }
 
+// -------------------------------------------------------
+bool SettingsScreen::update() {
+    if (_active && _page == SettingsPage::LanguageBrowser) {
+        // Background catalog refresh: redraw if it brought a new catalog
+        uint8_t revision = packMgr::catalogRevision();
+        packMgr::update();
+        if (packMgr::catalogRevision() == revision) return false;
+        int count = packMgr::languageCount();
+        if (_selectedLang >= count) _selectedLang = -1;
+        int lastPage = count > 0 ? (count - 1) / LANGS_PER_PAGE : 0;
+        if (_scrollOffset > lastPage) _scrollOffset = lastPage;
+        return true;
+    }
+    if (!_active || _page != SettingsPage::DownloadProgress) return false;
+
+    packMgr::update();
+
+    switch (packMgr::state()) {
+        case PackDownloadState::Complete: {
+            // Show "Restarting..." message then reboot.
+            // Rebooting ensures full heap is available for vocab loading.
+            // Settings are already saved by the download.
+            TFT_eSPI& tft = display.tft();
+            tft.fillScreen(CLR_BG_DARK);
+            tft.setTextDatum(TC_DATUM);
+            tft.setTextColor(CLR_ACCENT);
+            tft.drawString("Pack Installed!", SCREEN_W / 2, 100, 4);
+            tft.setTextColor(CLR_TEXT_SECONDARY);
+            tft.drawString("Restarting...", SCREEN_W / 2, 150, 2);
+            drawInstallStats(tft, 190);
+            delay(1500);
+            ESP.restart();
+            break;
+        }
+        case PackDownloadState::Error:
+            showDownloadStopped("Download Failed", true);
+            break;
+        case PackDownloadState::Cancelled:
+            showDownloadStopped("Cancelled", true);
+            break;
+        default:
+            break;
+    }
+    return true;  // Progress may have moved
+}
+
+// -------------------------------------------------------
+void SettingsScreen::showDownloadStopped(const char* title, bool withStats) {
+    // Show the reason briefly then return to browser
+    TFT_eSPI& tft = display.tft();
+    tft.fillScreen(CLR_BG_DARK);
+    tft.setTextDatum(TC_DATUM);
+    tft.setTextColor(0xF800);  // Red
+    tft.drawString(title, SCREEN_W / 2, 120, 4);
+    tft.setTextColor(CLR_TEXT_SECONDARY);
+    tft.drawString(packMgr::statusText(), SCREEN_W / 2, 160, 2);
+    if (withStats) drawInstallStats(tft, 200);
+    delay(3000);
+    dirtyRegion.markAll();  // Drawn outside the strip renderer
+    packMgr::resetState();
+    _selectedLang = -1;
+    _scrollOffset = 0;
+    _page = SettingsPage::LanguageBrowser;
+}
+
 // -------------------------------------------------------
 bool SettingsScreen::handleMainTap(TouchPoint pt) {
     OsmosisSettings& s = settingsMgr.settings();
@@ -543,13 +726,11 @@ bool SettingsScreen::handleMainTap(TouchPoint pt) {
             _page = SettingsPage::LanguageBrowser;
             _selectedLang = -1;
             _scrollOffset = 0;
-            if (wifiMgr::isConnected()) {
-                // Fetch catalog if not already loaded
-                if (packMgr::languageCount() == 0) {
-                    packMgr::fetchCatalog();
-                }
-            } else if (wifiMgr::state() == WiFiState::Disconnected ||
-                       wifiMgr::state() == WiFiState::NotConfigured) {
+            // Open on the cached catalog; update() refreshes it once Wi-Fi is up
+            if (packMgr::languageCount() == 0) packMgr::loadCachedCatalog();
+            packMgr::refreshCatalog();
+            if (!wifiMgr::isConnected() && (wifiMgr::state() == WiFiState::Disconnected ||
+                                            wifiMgr::state() == WiFiState::NotConfigured)) {
                 // Start captive portal only if truly disconnected (not still connecting)
                 wifiMgr::startCaptivePortal();
             }
@@ -613,7 +794,6 @@ bool SettingsScreen::handleBrowserTap(TouchPoint pt) {
 
     if (_selectedLang < 0) {
         // Language list with pagination
-        const int LANGS_PER_PAGE = 6;
         int startIdx = _scrollOffset * LANGS_PER_PAGE;
         int endIdx = startIdx + LANGS_PER_PAGE;
         if (endIdx > count) endIdx = count;
@@ -659,65 +839,9 @@ bool SettingsScreen::handleBrowserTap(TouchPoint pt) {
             Button btn = {20, btnY, 200, 36};
             if (hitTest(btn, pt)) {
                 flashPress();
-                // Switch to download progress page
+                // Switch to download progress page; update() drives the download
                 _page = SettingsPage::DownloadProgress;
-
-                // Set progress callback to redraw screen during download
-                packMgr::setProgressCallback([]() {
-                    TFT_eSprite& spr = display.getStrip();
-                    for (int strip = 0; strip < NUM_STRIPS; strip++) {
-                        int sy = strip * STRIP_H;
-                        spr.fillSprite(CLR_BG_DARK);
-                        settingsUI.drawDownloadProgress(spr, sy);
-                        display.pushStrip(sy);
-                    }
-                });
-
-                // Draw initial progress screen before blocking download
-                {
-                    TFT_eSprite& spr = display.getStrip();
-                    for (int strip = 0; strip < NUM_STRIPS; strip++) {
-                        int sy = strip * STRIP_H;
-                        spr.fillSprite(CLR_BG_DARK);
-                        settingsUI.drawDownloadProgress(spr, sy);
-                        display.pushStrip(sy);
-                    }
-                }
-
-                // Synchronous/blocking download (callback redraws progress during this)
-                bool ok = packMgr::startDownload(_selectedLang, i);
-
-                // Clear callback after download
-                packMgr::setProgressCallback(nullptr);
-
-                if (ok && packMgr::state() == PackDownloadState::Complete) {
-                    // Show "Restarting..." message then reboot.
-                    // Rebooting ensures full heap is available for vocab loading.
-                    // Settings are already saved by startDownload().
-                    TFT_eSPI& tft = display.tft();
-                    tft.fillScreen(CLR_BG_DARK);
-                    tft.setTextDatum(TC_DATUM);
-                    tft.setTextColor(CLR_ACCENT);
-                    tft.drawString("Pack Installed!", SCREEN_W / 2, 100, 4);
-                    tft.setTextColor(CLR_TEXT_SECONDARY);
-                    tft.drawString("Restarting...", SCREEN_W / 2, 150, 2);
-                    delay(1500);
-                    ESP.restart();
-                } else {
-                    // Download failed — show error briefly then return to browser
-                    TFT_eSPI& tft = display.tft();
-                    tft.fillScreen(CLR_BG_DARK);
-                    tft.setTextDatum(TC_DATUM);
-                    tft.setTextColor(0xF800);  // Red
-                    tft.drawString("Download Failed", SCREEN_W / 2, 120, 4);
-                    tft.setTextColor(CLR_TEXT_SECONDARY);
-                    tft.drawString(packMgr::statusText(), SCREEN_W / 2, 160, 2);
-                    delay(3000);
-                    packMgr::resetState();
-                    _selectedLang = -1;
-                    _scrollOffset = 0;
-                    _page = SettingsPage::LanguageBrowser;
-                }
+                if (!packMgr::startDownload(_selectedLang, i)) showDownloadStopped("Download Failed", false);
                 return true;
             }
         }
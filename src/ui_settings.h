@@ -13,16 +13,19 @@ public:
     bool isActive() const { return _active; }
     void show();
     void hide();
+    void resumeDownload();  // Straight to the progress page of a journalled install
     void draw(TFT_eSprite& spr, int stripY);
+    void render();  // Repaint the strips whose content changed since the last frame
     bool handleTap(TouchPoint pt);
+    bool update();  // Advance a pack download or catalog refresh; true if the page may have changed
     SettingsPage currentPage() const { return _page; }
     void drawDownloadProgress(TFT_eSprite& spr, int stripY);
 
 private:
     bool _active = false;
     SettingsPage _page = SettingsPage::Main;
-    int8_t _selectedLang = -1;  // Selected language index in browser
-    int8_t _scrollOffset = 0;
+    int16_t _selectedLang = -1;  // Selected language index in browser (up to MAX_LANGUAGES)
+    int16_t _scrollOffset = 0;
 
     struct Button { int x, y, w, h; };
 
@@ -31,6 +34,28 @@ private:
     uint32_t _pressedMs = 0;
     static const uint32_t PRESS_FLASH_MS = 200;
 
+    // State shown by the last frame, compared in markChanges()
+    struct DrawnState {
+        SettingsPage page;
+        int16_t selectedLang;
+        int16_t scrollOffset;
+        uint8_t langCount;
+        uint8_t catalogRev;
+        uint8_t wordsPerDay;
+        uint16_t displaySecs;
+        uint8_t brightness;
+        bool showPhonetic;
+        uint8_t wifiState;
+        char ssid[33];
+        uint8_t progress;
+        bool pressed;
+        Button pressedBtn;
+        char status[48];
+    };
+    DrawnState _drawn = {};
+
+    bool pressActive() const;
+    void markChanges();
     bool hitTest(const Button& btn, TouchPoint pt);
     void flashPress();  // Immediate render to show blue press feedback
     void drawButton(TFT_eSprite& spr, const Button& btn, int stripY,
@@ -41,6 +66,7 @@ private:
 
     bool handleMainTap(TouchPoint pt);
     bool handleBrowserTap(TouchPoint pt);
+    void showDownloadStopped(const char* title, bool withStats);  // Error/cancel screen, back to browser
 };
 
 extern SettingsScreen settingsUI;
@@ -5,92 +5,327 @@
 #include <SPIFFS.h>
 #include <cstring>
 
-static WordEntry* _words = nullptr;
+// Binary pack written by tools/build_pack.py (see there for the layout):
+// 32-byte header, 20-byte entry per word, then a pool of NUL-terminated
+// strings. All integers little-endian. The entry table is the index: word i
+// is found at a fixed file offset, so words are read from flash on demand.
+static const char* PACK_PATH = "/vocab.pack";
+static const char* PACK_TMP_PATH = "/vocab.pack.tmp";
+static const char* MANIFEST_PATH = "/manifest.json";
+static const uint8_t VPK_FORMAT = 1;
+static const size_t VPK_HEADER_SIZE = 32;
+static const size_t VPK_ENTRY_SIZE = 20;
+
+// Pack on SPIFFS: only its header is kept in RAM
 static uint16_t _wordCount = 0;
+static uint32_t _poolStart = 0;
+static uint32_t _poolSize = 0;
 static PackInfo _packInfo;
 static bool _loaded = false;
 
-namespace vocabLoader {
+// Words of the current batch and their strings. The arena keeps its
+// capacity between batches, so resident memory depends on the batch size,
+// not on the size of the pack.
+static WordEntry _batch[MAX_BATCH_WORDS];
+static uint8_t _batchCount = 0;
+static char* _arena = nullptr;
+static uint32_t _arenaSize = 0;
+static uint32_t _arenaUsed = 0;
 
-bool load() {
-    // Free previous data
-    if (_words) {
-        free(_words);
-        _words = nullptr;
-    }
-    _wordCount = 0;
-    _loaded = false;
-    memset(&_packInfo, 0, sizeof(_packInfo));
+// WordEntry offsets are 16-bit, so the arena holds at most 64 KB of strings
+static const uint32_t MAX_ARENA = 0x10000;
+static const uint32_t ARENA_STEP = 256;
 
-    fs::File f = SPIFFS.open("/manifest.json", "r");
-    if (!f) {
-        Serial.println("[vocab] No manifest.json found on SPIFFS");
+static const WordEntry NO_WORD = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
+
+static uint16_t readU16LE(const uint8_t* p) {
+    return (uint16_t)p[0] | (uint16_t)(p[1] << 8);
+}
+
+static uint32_t readU32LE(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putU16LE(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32LE(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static bool arenaAppend(const char* data, size_t len) {
+    if (_arenaUsed + len > MAX_ARENA) {
+        Serial.printf("[vocab] Batch strings exceed the %u byte arena\n", MAX_ARENA);
         return false;
     }
+    if (_arenaUsed + len > _arenaSize) {
+        uint32_t size = (_arenaUsed + len + ARENA_STEP - 1) / ARENA_STEP * ARENA_STEP;
+        if (size > MAX_ARENA) size = MAX_ARENA;
+        char* grown = (char*)realloc(_arena, size);
+        if (!grown) {
+            Serial.printf("[vocab] Failed to grow string arena to %u bytes\n", size);
+            return false;
+        }
+        _arena = grown;
+        _arenaSize = size;
+    }
+    memcpy(_arena + _arenaUsed, data, len);
+    _arenaUsed += len;
+    return true;
+}
+
+// Copies the pool string at `off` into the arena; out-of-range offsets
+// become an empty string
+static bool appendPoolString(fs::File& f, uint32_t off, uint16_t& arenaOff) {
+    arenaOff = (uint16_t)_arenaUsed;
+    if (off >= _poolSize) return arenaAppend("", 1);
+    if (!f.seek(_poolStart + off)) return false;
+
+    // The pool ends in a NUL (checked at load), so this always terminates
+    char buf[32];
+    for (;;) {
+        size_t n = f.read((uint8_t*)buf, sizeof(buf));
+        if (n == 0) return false;
+        const char* nul = (const char*)memchr(buf, '\0', n);
+        size_t take = nul ? (size_t)(nul - buf) + 1 : n;
+        if (!arenaAppend(buf, take)) return false;
+        if (nul) return true;
+    }
+}
+
+// Reads a pool string into a fixed buffer, truncating (pack info only)
+static void readPoolString(fs::File& f, uint32_t off, char* dst, size_t size) {
+    dst[0] = '\0';
+    if (off >= _poolSize || !f.seek(_poolStart + off)) return;
+    size_t n = f.read((uint8_t*)dst, size - 1);
+    dst[n] = '\0';
+}
+
+// Validates /vocab.pack and reads its header; no words are loaded
+static bool openPack() {
+    fs::File f = SPIFFS.open(PACK_PATH, "r");
+    if (!f) return false;
 
     size_t fileSize = f.size();
-    Serial.printf("[vocab] Loading manifest.json (%u bytes)\n", (uint32_t)fileSize);
+    uint8_t header[VPK_HEADER_SIZE];
+    if (f.read(header, VPK_HEADER_SIZE) != VPK_HEADER_SIZE ||
+        memcmp(header, "OVPK", 4) != 0 || header[4] != VPK_FORMAT) {
+        Serial.println("[vocab] vocab.pack: bad header");
+        return false;
+    }
 
-    // Parse JSON
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, f);
-    f.close();
+    uint16_t count = readU16LE(&header[6]);
+    uint32_t poolSize = readU32LE(&header[8]);
+    size_t poolStart = VPK_HEADER_SIZE + (size_t)count * VPK_ENTRY_SIZE;
+    uint8_t last = 0xFF;
+    if (count == 0 || poolSize == 0 || poolStart + poolSize != fileSize ||
+        !f.seek(fileSize - 1) || f.read(&last, 1) != 1 || last != '\0') {
+        Serial.printf("[vocab] vocab.pack: inconsistent sizes (%u words, %u byte pool, %u byte file)\n",
+                      count, poolSize, (uint32_t)fileSize);
+        return false;
+    }
+
+    _wordCount = count;
+    _poolStart = poolStart;
+    _poolSize = poolSize;
+
+    const uint8_t* h = &header[12];
+    readPoolString(f, readU32LE(h), _packInfo.language, sizeof(_packInfo.language));
+    readPoolString(f, readU32LE(h + 4), _packInfo.languageDisplay, sizeof(_packInfo.languageDisplay));
+    readPoolString(f, readU32LE(h + 8), _packInfo.tier, sizeof(_packInfo.tier));
+    readPoolString(f, readU32LE(h + 12), _packInfo.tierDisplay, sizeof(_packInfo.tierDisplay));
+    readPoolString(f, readU32LE(h + 16), _packInfo.fontFile, sizeof(_packInfo.fontFile));
+    _packInfo.version = header[5];
+    _packInfo.wordCount = count;
+
+    Serial.printf("[vocab] Opened vocab.pack (%u bytes, %u words)\n", (uint32_t)fileSize, count);
+    return true;
+}
+
+// Writes /vocab.pack from /manifest.json, for packs that ship without one.
+// Only done once: later boots open the pack directly.
+static bool convertManifest() {
+    fs::File in = SPIFFS.open(MANIFEST_PATH, "r");
+    if (!in) {
+        Serial.println("[vocab] No manifest.json found on SPIFFS");
+        return false;
+    }
+    Serial.printf("[vocab] Converting manifest.json (%u bytes)\n", (uint32_t)in.size());
 
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, in);
+    in.close();
     if (err) {
         Serial.printf("[vocab] JSON parse error: %s\n", err.c_str());
         return false;
     }
 
-    // Extract pack info
-    strlcpy(_packInfo.language, doc["language"] | "", sizeof(_packInfo.language));
-    strlcpy(_packInfo.languageDisplay, doc["languageDisplay"] | "", sizeof(_packInfo.languageDisplay));
-    strlcpy(_packInfo.tier, doc["tier"] | "", sizeof(_packInfo.tier));
-    strlcpy(_packInfo.tierDisplay, doc["tierDisplay"] | "", sizeof(_packInfo.tierDisplay));
-    _packInfo.version = doc["version"] | 0;
-    _packInfo.wordCount = doc["wordCount"] | 0;
-    strlcpy(_packInfo.fontFile, doc["fontFile"] | "", sizeof(_packInfo.fontFile));
-
-    // Extract words array
     JsonArray wordsArr = doc["words"];
     if (wordsArr.isNull()) {
         Serial.println("[vocab] No 'words' array in manifest");
         return false;
     }
-
-    _wordCount = wordsArr.size();
-    if (_wordCount == 0) {
-        Serial.println("[vocab] Empty words array");
+    size_t count = wordsArr.size();
+    if (count == 0 || count > 0xFFFF) {
+        Serial.printf("[vocab] Unusable words array (%u entries)\n", (uint32_t)count);
         return false;
     }
 
-    // Allocate word array on heap
-    _words = (WordEntry*)malloc(_wordCount * sizeof(WordEntry));
-    if (!_words) {
-        Serial.printf("[vocab] Failed to allocate %u bytes for %u words\n",
-                      (uint32_t)(_wordCount * sizeof(WordEntry)), _wordCount);
-        _wordCount = 0;
+    static const char* const PACK_FIELDS[] = {"language", "languageDisplay", "tier", "tierDisplay", "fontFile"};
+    static const char* const WORD_FIELDS[] = {"word", "english", "phonetic", "emoji", "category"};
+
+    // Same layout as build_pack.py, without string de-duplication
+    uint8_t header[VPK_HEADER_SIZE] = {'O', 'V', 'P', 'K', VPK_FORMAT, (uint8_t)(doc["version"] | 0)};
+    putU16LE(&header[6], (uint16_t)count);
+    uint32_t poolSize = 0;
+    for (int k = 0; k < 5; k++) {
+        putU32LE(&header[12 + 4 * k], poolSize);
+        poolSize += strlen(doc[PACK_FIELDS[k]] | "") + 1;
+    }
+    uint32_t wordsStart = poolSize;
+    for (JsonObject w : wordsArr) {
+        for (const char* field : WORD_FIELDS) poolSize += strlen(w[field] | "") + 1;
+    }
+    putU32LE(&header[8], poolSize);
+
+    fs::File out = SPIFFS.open(PACK_TMP_PATH, "w");
+    if (!out) {
+        Serial.println("[vocab] Failed to create vocab.pack");
         return false;
     }
-    memset(_words, 0, _wordCount * sizeof(WordEntry));
+    bool ok = out.write(header, VPK_HEADER_SIZE) == VPK_HEADER_SIZE;
+
+    uint32_t off = wordsStart;
+    for (JsonObject w : wordsArr) {
+        uint8_t entry[VPK_ENTRY_SIZE];
+        for (int k = 0; k < 5; k++) {
+            putU32LE(&entry[4 * k], off);
+            off += strlen(w[WORD_FIELDS[k]] | "") + 1;
+        }
+        ok = ok && out.write(entry, VPK_ENTRY_SIZE) == VPK_ENTRY_SIZE;
+    }
+    for (const char* field : PACK_FIELDS) {
+        const char* str = doc[field] | "";
+        ok = ok && out.write((const uint8_t*)str, strlen(str) + 1) == strlen(str) + 1;
+    }
+    for (JsonObject w : wordsArr) {
+        for (const char* field : WORD_FIELDS) {
+            const char* str = w[field] | "";
+            ok = ok && out.write((const uint8_t*)str, strlen(str) + 1) == strlen(str) + 1;
+        }
+    }
+    out.close();
 
-    for (uint16_t i = 0; i < _wordCount; i++) {
-        JsonObject w = wordsArr[i];
-        strlcpy(_words[i].word, w["word"] | "", sizeof(_words[i].word));
-        strlcpy(_words[i].english, w["english"] | "", sizeof(_words[i].english));
-        strlcpy(_words[i].phonetic, w["phonetic"] | "", sizeof(_words[i].phonetic));
-        strlcpy(_words[i].emoji, w["emoji"] | "", sizeof(_words[i].emoji));
-        strlcpy(_words[i].category, w["category"] | "", sizeof(_words[i].category));
+    if (ok) {
+        SPIFFS.remove(PACK_PATH);
+        ok = SPIFFS.rename(PACK_TMP_PATH, PACK_PATH);
+    }
+    if (!ok) {
+        Serial.println("[vocab] Failed to write vocab.pack");
+        SPIFFS.remove(PACK_TMP_PATH);
+    }
+    return ok;
+}
+
+static void unload() {
+    if (_arena) {
+        free(_arena);
+        _arena = nullptr;
+    }
+    _arenaSize = 0;
+    _arenaUsed = 0;
+    _batchCount = 0;
+    _wordCount = 0;
+    _poolStart = 0;
+    _poolSize = 0;
+    _loaded = false;
+    memset(&_packInfo, 0, sizeof(_packInfo));
+}
+
+namespace vocabLoader {
+
+bool load() {
+    // Free previous data
+    unload();
+
+    // Prefer the binary pack; packs without one (or with a bad one) get it
+    // rebuilt from manifest.json
+    if (!openPack()) {
+        if (SPIFFS.exists(PACK_PATH)) {
+            Serial.println("[vocab] vocab.pack unusable, rebuilding from manifest.json");
+        }
+        if (!convertManifest() || !openPack()) {
+            unload();
+            return false;
+        }
     }
 
     _loaded = true;
-    Serial.printf("[vocab] Loaded %u words (%s %s)\n",
+    Serial.printf("[vocab] Pack ready: %u words (%s %s)\n",
                   _wordCount, _packInfo.languageDisplay, _packInfo.tierDisplay);
     return true;
 }
 
+bool loadBatch(const uint16_t* indices, uint8_t count) {
+    _batchCount = 0;
+    _arenaUsed = 0;
+    if (!_loaded) return false;
+    if (count > MAX_BATCH_WORDS) count = MAX_BATCH_WORDS;
+
+    fs::File f = SPIFFS.open(PACK_PATH, "r");
+    if (!f) {
+        Serial.println("[vocab] vocab.pack disappeared");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t entry[VPK_ENTRY_SIZE];
+        if (indices[i] >= _wordCount ||
+            !f.seek(VPK_HEADER_SIZE + (size_t)indices[i] * VPK_ENTRY_SIZE) ||
+            f.read(entry, VPK_ENTRY_SIZE) != VPK_ENTRY_SIZE) {
+            Serial.printf("[vocab] Failed to read word %u\n", indices[i]);
+            _arenaUsed = 0;
+            return false;
+        }
+
+        WordEntry& w = _batch[i];
+        if (!appendPoolString(f, readU32LE(entry), w.wordOff) ||
+            !appendPoolString(f, readU32LE(entry + 4), w.englishOff) ||
+            !appendPoolString(f, readU32LE(entry + 8), w.phoneticOff) ||
+            !appendPoolString(f, readU32LE(entry + 12), w.emojiOff) ||
+            !appendPoolString(f, readU32LE(entry + 16), w.categoryOff)) {
+            Serial.printf("[vocab] Failed to read strings of word %u\n", indices[i]);
+            _arenaUsed = 0;
+            return false;
+        }
+    }
+    f.close();
+
+    _batchCount = count;
+    Serial.printf("[vocab] Loaded batch of %u words (%u bytes resident)\n",
+                  count, (uint32_t)heapBytes());
+    return true;
+}
+
+const WordEntry& batchWord(uint8_t pos) {
+    return (pos < _batchCount) ? _batch[pos] : NO_WORD;
+}
+
+uint8_t batchCount() { return _batchCount; }
+
+const char* string(uint16_t offset) {
+    return (offset < _arenaUsed) ? _arena + offset : "";
+}
+
 bool isLoaded() { return _loaded; }
-const WordEntry* words() { return _words; }
 uint16_t wordCount() { return _wordCount; }
 const PackInfo& packInfo() { return _packInfo; }
+size_t heapBytes() { return sizeof(_batch) + _arenaSize; }
 
 }  // namespace vocabLoader
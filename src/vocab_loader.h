@@ -1,12 +1,29 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
+// Most words a batch can hold (CardManager's daily batch)
+constexpr uint8_t MAX_BATCH_WORDS = 25;
+
+namespace vocabLoader {
+    const char* string(uint16_t offset);  // String at an arena offset ("" if out of range)
+}
+
+// Strings live in one arena owned by vocabLoader and are referenced by
+// offset, so an entry is 10 bytes and words of any length or script are
+// kept whole. Entries are only valid until the next loadBatch().
 struct WordEntry {
-    char word[32];       // Foreign word
-    char english[32];    // English translation
-    char phonetic[40];   // Phonetic pronunciation
-    char emoji[12];      // Codepoint hex string (e.g. "1f4a7")
-    char category[16];   // Category
+    uint16_t wordOff;
+    uint16_t englishOff;
+    uint16_t phoneticOff;
+    uint16_t emojiOff;
+    uint16_t categoryOff;
+
+    const char* word() const { return vocabLoader::string(wordOff); }          // Foreign word
+    const char* english() const { return vocabLoader::string(englishOff); }    // English translation
+    const char* phonetic() const { return vocabLoader::string(phoneticOff); }  // Phonetic pronunciation
+    const char* emoji() const { return vocabLoader::string(emojiOff); }        // Codepoint hex string (e.g. "1f4a7")
+    const char* category() const { return vocabLoader::string(categoryOff); }  // Category
 };
 
 struct PackInfo {
@@ -20,9 +37,14 @@ struct PackInfo {
 };
 
 namespace vocabLoader {
-    bool load();                          // Parse /manifest.json from SPIFFS
+    bool load();                          // Open /vocab.pack (built from /manifest.json if missing)
     bool isLoaded();
-    const WordEntry* words();             // Pointer to word array
-    uint16_t wordCount();
+    uint16_t wordCount();                 // Words in the pack
     const PackInfo& packInfo();
+
+    // Words stay on flash; only the current batch is read into RAM
+    bool loadBatch(const uint16_t* indices, uint8_t count);  // Replaces the previous batch
+    const WordEntry& batchWord(uint8_t pos);                 // i-th requested word (empty if out of range)
+    uint8_t batchCount();
+    size_t heapBytes();                   // Batch entries + string arena
 }
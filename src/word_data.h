@@ -1,7 +1,6 @@
 #pragma once
 #include "vocab_loader.h"
 
-// v2.0: Word data now loaded dynamically from /manifest.json
-// WORD_LIST and WORD_COUNT are compatibility shims for card_manager
-#define WORD_LIST  (vocabLoader::words())
+// v2.0: Word data now loaded dynamically from the installed pack
+// WORD_COUNT is a compatibility shim for card_manager
 #define WORD_COUNT (vocabLoader::wordCount())
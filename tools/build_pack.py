@@ -1,17 +1,85 @@
 #!/usr/bin/env python3
 """Build a language pack from a vocab CSV file.
 
+Writes manifest.json and its binary form, vocab.pack. With --emoji-dir, also
+writes emoji.bundle, every ORLE image the pack uses in one download, and
+assets.idx, the size and CRC-32 of each image and of the --font file. With
+--provision, also writes the pack as a device holds it, for flashing over USB
+without Wi-Fi: assets.part, an image of the assets partition with the font
+and emoji, and a spiffs/ directory with manifest.json, vocab.pack and the
+inventory.idx that says where each file is in the image.
+
 Usage:
     python3 tools/build_pack.py --csv tools/vocab/spanish_beginner.csv \
-        --output packs/spanish/beginner/ --language spanish --tier beginner
+        --output packs/spanish/beginner/ --language spanish --tier beginner \
+        --emoji-dir packs/emoji/ --font packs/spanish/font.vlw
+
+    # vocab.pack for an existing manifest (e.g. the bundled data/ image)
+    python3 tools/build_pack.py --manifest data/manifest.json --output data/
+
+    # data/ as a device image (see --provision above)
+    python3 tools/build_pack.py --manifest data/manifest.json --output build/pack/ \
+        --emoji-dir data/ --font data/font.vlw --provision build/provision/
 """
 
 import argparse
 import csv
 import json
+import struct
+import zlib
 from pathlib import Path
 
 
+# Binary vocab pack (vocab.pack), loaded by the firmware instead of parsing
+# manifest.json when present. All integers little-endian:
+#
+#   header   "OVPK", u8 format version, u8 pack version, u16 word count,
+#            u32 string pool size, then u32 pool offsets of language,
+#            languageDisplay, tier, tierDisplay and fontFile (32 bytes)
+#   entries  per word, u32 pool offsets of word, english, phonetic, emoji
+#            and category (20 bytes each)
+#   pool     NUL-terminated UTF-8 strings, each stored once
+VPK_MAGIC = b"OVPK"
+VPK_FORMAT = 1
+PACK_FIELDS = ["language", "languageDisplay", "tier", "tierDisplay", "fontFile"]
+WORD_FIELDS = ["word", "english", "phonetic", "emoji", "category"]
+
+# Per-pack emoji bundle (emoji.bundle), split back into <codepoint>.bin files
+# by the firmware while it downloads. All integers little-endian:
+#
+#   header   "OEBN", u8 format version, u8 reserved, u16 image count
+#   index    per image, NUL-padded codepoint name (12 bytes), u32 offset of
+#            the image from the start of the file, u32 size (20 bytes each)
+#   data     the .bin files back to back, in index order
+BUNDLE_MAGIC = b"OEBN"
+BUNDLE_FORMAT = 1
+BUNDLE_NAME_LEN = 12
+
+# Asset list (assets.idx): every file of the pack besides manifest.json and
+# vocab.pack, so the firmware only downloads what it doesn't already hold.
+# All integers little-endian:
+#
+#   header   "OAST", u8 format version, u8 reserved, u16 file count
+#   entries  sorted by name: NUL-padded file name (16 bytes), u32 size,
+#            u32 CRC-32 of the contents (24 bytes each)
+ASSETS_MAGIC = b"OAST"
+ASSETS_FORMAT = 1
+ASSET_NAME_LEN = 16
+
+# Device inventory (inventory.idx on SPIFFS, see src/asset_store.cpp): where
+# each file is in the assets partition. All integers little-endian:
+#
+#   header   "OINV", u8 format version, u8 reserved, u16 file count,
+#            u32 sequence number of the last install
+#   entries  sorted by name: NUL-padded file name (16 bytes), u32 size,
+#            u32 CRC-32, u32 install that last used it (0: removed), u32
+#            offset of the contents in the partition (32 bytes each)
+INVENTORY_MAGIC = b"OINV"
+INVENTORY_FORMAT = 3
+FLASH_SECTOR = 4096
+PARTITION_TABLE = Path(__file__).resolve().parent.parent / "partitions_ota.csv"
+
+
 LANG_DISPLAY = {
     "spanish": "Spanish", "french": "French",
     "portuguese_br": "Portuguese (BR)", "portuguese_pt": "Portuguese (PT)",
@@ -65,11 +133,168 @@ def build_manifest(csv_path, output_dir, language, tier):
     return manifest
 
 
+def build_binary(manifest, output_dir):
+    """Write vocab.pack, the binary form of manifest.json."""
+    pool = bytearray()
+    offsets = {}
+
+    def intern(text):
+        if text not in offsets:
+            offsets[text] = len(pool)
+            pool.extend(text.encode("utf-8") + b"\0")
+        return offsets[text]
+
+    header_offsets = [intern(manifest[k]) for k in PACK_FIELDS]
+    entries = bytearray()
+    for w in manifest["words"]:
+        entries += struct.pack("<5I", *(intern(w[k]) for k in WORD_FIELDS))
+
+    words = len(manifest["words"])
+    if words > 0xFFFF:
+        raise ValueError(f"{words} words do not fit the u16 word count")
+
+    data = VPK_MAGIC
+    data += struct.pack("<BBHI", VPK_FORMAT, manifest["version"], words, len(pool))
+    data += struct.pack("<5I", *header_offsets)
+    data += entries + pool
+
+    pack_path = Path(output_dir) / "vocab.pack"
+    with open(pack_path, 'wb') as f:
+        f.write(data)
+
+    print(f"Written {pack_path} ({len(data)} bytes, {len(pool)} byte string pool)")
+
+
+def pack_images(manifest, emoji_dir):
+    """(codepoint, .bin contents) for each distinct emoji, in word order."""
+    names = []
+    for w in manifest["words"]:
+        cp = w["emoji"]
+        if cp and cp not in names:
+            names.append(cp)
+
+    images = []
+    for cp in names:
+        if len(cp.encode("ascii")) >= BUNDLE_NAME_LEN:
+            raise ValueError(f"emoji name {cp!r} does not fit the bundle index")
+        path = Path(emoji_dir) / f"{cp}.bin"
+        if not path.exists():
+            print(f"WARNING: {path} not found, left out of the pack")
+            continue
+        images.append((cp, path.read_bytes()))
+    return images
+
+
+def build_bundle(images, output_dir):
+    """Write emoji.bundle from pack_images() output."""
+    offset = 8 + 20 * len(images)
+    index = bytearray()
+    for cp, data in images:
+        index += struct.pack("<12sII", cp.encode("ascii"), offset, len(data))
+        offset += len(data)
+
+    data = BUNDLE_MAGIC + struct.pack("<BBH", BUNDLE_FORMAT, 0, len(images)) + index
+    data += b"".join(img for _, img in images)
+
+    bundle_path = Path(output_dir) / "emoji.bundle"
+    with open(bundle_path, 'wb') as f:
+        f.write(data)
+
+    print(f"Written {bundle_path} ({len(images)} images, {len(data)} bytes)")
+
+
+def build_assets(images, font_path, output_dir):
+    """Write assets.idx for the images and, if given, the font."""
+    files = {f"{cp}.bin": data for cp, data in images}
+    if font_path:
+        files["font.vlw"] = Path(font_path).read_bytes()
+
+    data = ASSETS_MAGIC + struct.pack("<BBH", ASSETS_FORMAT, 0, len(files))
+    for name in sorted(files):
+        data += struct.pack("<16sII", name.encode("ascii"), len(files[name]),
+                            zlib.crc32(files[name]))
+
+    assets_path = Path(output_dir) / "assets.idx"
+    with open(assets_path, 'wb') as f:
+        f.write(data)
+
+    print(f"Written {assets_path} ({len(files)} files)")
+
+
+def assets_partition():
+    """(offset, size) of the assets partition in partitions_ota.csv."""
+    with open(PARTITION_TABLE) as f:
+        for line in f:
+            fields = [x.strip() for x in line.split(",")]
+            if not line.startswith("#") and fields[0] == "assets":
+                return int(fields[3], 0), int(fields[4], 0)
+    raise ValueError(f"no assets partition in {PARTITION_TABLE}")
+
+
+def build_provision(manifest, images, font_path, provision_dir):
+    """Write assets.part and spiffs/ for a device flashed over USB."""
+    files = [(f"{cp}.bin", data) for cp, data in images]
+    if font_path:
+        files.insert(0, ("font.vlw", Path(font_path).read_bytes()))
+    flash_offset, capacity = assets_partition()
+
+    # Back to back, as the firmware writes them. One install (1) uses them all.
+    image = bytearray()
+    inventory = []
+    for name, data in files:
+        inventory.append((name, len(data), zlib.crc32(data), 1, len(image)))
+        image += data
+    if len(image) > capacity:
+        raise ValueError(f"{len(image)} bytes of assets do not fit the {capacity} byte partition")
+    # Only whole sectors in use: esptool erases what it writes, and the
+    # firmware erases the rest of the partition as it needs it
+    image += b"\xff" * (-len(image) % FLASH_SECTOR)
+
+    data = INVENTORY_MAGIC + struct.pack("<BBHI", INVENTORY_FORMAT, 0, len(inventory), 1)
+    for name, size, crc, used, offset in sorted(inventory):
+        data += struct.pack("<16sIIII", name.encode("ascii"), size, crc, used, offset)
+
+    out = Path(provision_dir)
+    spiffs = out / "spiffs"
+    spiffs.mkdir(parents=True, exist_ok=True)
+    with open(out / "assets.part", 'wb') as f:
+        f.write(image)
+    with open(spiffs / "inventory.idx", 'wb') as f:
+        f.write(data)
+    with open(spiffs / "manifest.json", 'w') as f:
+        json.dump(manifest, f, indent=2, ensure_ascii=False)
+    build_binary(manifest, spiffs)
+
+    print(f"Written {out / 'assets.part'} ({len(files)} files, {len(image)} of {capacity} bytes)")
+    print(f"  esptool.py write_flash {flash_offset:#x} {out / 'assets.part'}")
+    print(f"  PLATFORMIO_DATA_DIR={spiffs} pio run --target uploadfs")
+
+
 if __name__ == "__main__":
-    parser = argparse.ArgumentParser(description="Build a language pack manifest")
-    parser.add_argument("--csv", required=True, help="Path to vocab CSV file")
+    parser = argparse.ArgumentParser(description="Build a language pack manifest and vocab.pack")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--csv", help="Path to vocab CSV file")
+    source.add_argument("--manifest", help="Existing manifest.json to build vocab.pack from")
     parser.add_argument("--output", required=True, help="Output directory for pack files")
-    parser.add_argument("--language", required=True, help="Language ID (e.g. spanish)")
-    parser.add_argument("--tier", required=True, help="Tier ID (e.g. beginner)")
+    parser.add_argument("--language", help="Language ID (e.g. spanish)")
+    parser.add_argument("--tier", help="Tier ID (e.g. beginner)")
+    parser.add_argument("--emoji-dir", help="Directory of <codepoint>.bin images to bundle")
+    parser.add_argument("--font", help="The pack's font.vlw, listed in assets.idx")
+    parser.add_argument("--provision", help="Also write a device image here (needs --emoji-dir)")
     args = parser.parse_args()
-    build_manifest(args.csv, args.output, args.language, args.tier)
+    if args.manifest:
+        with open(args.manifest) as f:
+            manifest = json.load(f)
+    else:
+        if not args.language or not args.tier:
+            parser.error("--csv needs --language and --tier")
+        manifest = build_manifest(args.csv, args.output, args.language, args.tier)
+    build_binary(manifest, args.output)
+    if args.emoji_dir:
+        images = pack_images(manifest, args.emoji_dir)
+        build_bundle(images, args.output)
+        build_assets(images, args.font, args.output)
+        if args.provision:
+            build_provision(manifest, images, args.font, args.provision)
+    elif args.provision:
+        parser.error("--provision needs --emoji-dir")
@@ -1,5 +1,16 @@
 #!/usr/bin/env python3
-"""Convert emoji PNG images to RLE-compressed RGB565 .bin files for ESP32 SPIFFS."""
+"""Convert emoji PNG images to RLE-compressed RGB565 .bin files for the ESP32.
+
+Writes ORLE palette by default: the v1 header with magic "ORLP", a
+big-endian u16 palette size and up to 256 RGB565 entries (the image's most
+used colours), a big-endian u16 per row giving its offset in the payload,
+then each row RLE-coded on its own. Records hold up to 64 pixels: palette
+indices (one byte each) or, for colours left out, RGB565 values. The
+firmware draws these straight from the assets partition a few rows at a
+time. --v2 writes "ORL2": the same row table, with RGB565 records only
+and no palette. --v1 writes the original format (one RLE stream for the
+whole image). The firmware reads all three.
+"""
 
 import os
 import sys
@@ -39,7 +50,77 @@ def rle_compress(pixels):
                 result.extend(struct.pack('>H', pixels[j]))
     return bytes(result)
 
-def convert_image(input_path, output_path):
+PALETTE_MAX = 256
+PALETTE_RECORD_MAX = 64
+
+def palette_for(pixels):
+    """Up to PALETTE_MAX colours used more than once, most used first."""
+    counts = {}
+    for p in pixels:
+        counts[p] = counts.get(p, 0) + 1
+    used = sorted((c for c in counts if counts[c] > 1), key=lambda c: (-counts[c], c))
+    return used[:PALETTE_MAX]
+
+def palette_compress(pixels, index):
+    """RLE over palette indices, RGB565 for colours not in index.
+
+    Record header: bit 7 set for RGB565 values, else palette indices; bit 6
+    set for a run (one stored value), else a literal; bits 0-5 count - 1.
+    """
+    result = bytearray()
+
+    def put(values, run):
+        indexed = values[0] in index
+        result.append((0 if indexed else 0x80) | (0x40 if run else 0) | (len(values) - 1))
+        for v in values[:1] if run else values:
+            result.extend(struct.pack('B', index[v]) if indexed else struct.pack('>H', v))
+
+    i = 0
+    n = len(pixels)
+    while i < n:
+        run_len = 1
+        while i + run_len < n and pixels[i + run_len] == pixels[i] and run_len < PALETTE_RECORD_MAX:
+            run_len += 1
+        if run_len >= 3:
+            put(pixels[i:i + run_len], True)
+            i += run_len
+            continue
+        indexed = pixels[i] in index
+        lit_start = i
+        while i < n and i - lit_start < PALETTE_RECORD_MAX and (pixels[i] in index) == indexed:
+            if i < n - 2 and pixels[i] == pixels[i+1] == pixels[i+2]:
+                break
+            i += 1
+        put(pixels[lit_start:i], False)
+    return bytes(result)
+
+def encode_v1(pixels):
+    compressed = rle_compress(pixels)
+    return b'ORLE' + struct.pack('>HHI', IMG_SIZE, IMG_SIZE, len(compressed)) + compressed
+
+def encode_v2(pixels):
+    offsets = []
+    payload = bytearray()
+    for y in range(IMG_SIZE):
+        offsets.append(len(payload))
+        payload.extend(rle_compress(pixels[y * IMG_SIZE:(y + 1) * IMG_SIZE]))
+    table = b''.join(struct.pack('>H', o) for o in offsets)
+    return b'ORL2' + struct.pack('>HHI', IMG_SIZE, IMG_SIZE, len(payload)) + table + payload
+
+def encode_palette(pixels):
+    palette = palette_for(pixels)
+    index = {c: i for i, c in enumerate(palette)}
+    offsets = []
+    payload = bytearray()
+    for y in range(IMG_SIZE):
+        offsets.append(len(payload))
+        payload.extend(palette_compress(pixels[y * IMG_SIZE:(y + 1) * IMG_SIZE], index))
+    header = b'ORLP' + struct.pack('>HHI', IMG_SIZE, IMG_SIZE, len(payload))
+    entries = struct.pack('>H', len(palette)) + b''.join(struct.pack('>H', c) for c in palette)
+    table = b''.join(struct.pack('>H', o) for o in offsets)
+    return header + entries + table + payload
+
+def convert_image(input_path, output_path, encode):
     # Open as RGBA to preserve transparency, composite onto BLACK background
     # so transparent pixels become 0x0000 (RGB565 black = transparent in firmware)
     img = Image.open(input_path).convert('RGBA')
@@ -52,20 +133,22 @@ def convert_image(input_path, output_path):
         for x in range(IMG_SIZE):
             r, g, b = img.getpixel((x, y))
             pixels.append(rgb888_to_rgb565(r, g, b))
-    compressed = rle_compress(pixels)
-    raw_size = IMG_SIZE * IMG_SIZE * 2
+    data = encode(pixels)
     with open(output_path, 'wb') as f:
-        f.write(b'ORLE')
-        f.write(struct.pack('>HHI', IMG_SIZE, IMG_SIZE, len(compressed)))
-        f.write(compressed)
-    return raw_size, len(compressed) + 12
+        f.write(data)
+    return IMG_SIZE * IMG_SIZE * 2, len(data)
 
 def main():
-    if len(sys.argv) < 3:
-        print("Usage: convert_emoji.py <input_dir> <output_dir>")
+    args = sys.argv[1:]
+    encode = encode_palette
+    if args and args[0] in ('--v1', '--v2'):
+        encode = encode_v1 if args[0] == '--v1' else encode_v2
+        args = args[1:]
+    if len(args) < 2:
+        print("Usage: convert_emoji.py [--v1 | --v2] <input_dir> <output_dir>")
         sys.exit(1)
-    input_dir = Path(sys.argv[1])
-    output_dir = Path(sys.argv[2])
+    input_dir = Path(args[0])
+    output_dir = Path(args[1])
     output_dir.mkdir(parents=True, exist_ok=True)
     total_raw = 0
     total_compressed = 0
@@ -73,7 +156,7 @@ def main():
     for png in sorted(input_dir.glob('*.png')):
         name = png.stem
         out_path = output_dir / f"{name}.bin"
-        raw, compressed = convert_image(png, out_path)
+        raw, compressed = convert_image(png, out_path, encode)
         ratio = compressed / raw * 100
         print(f"  {name}: {raw} -> {compressed} bytes ({ratio:.1f}%)")
         total_raw += raw
@@ -81,9 +164,9 @@ def main():
         count += 1
     print(f"\n{count} images converted")
     print(f"Total: {total_raw/1024:.1f}KB raw -> {total_compressed/1024:.1f}KB compressed")
-    print(f"SPIFFS usage: {total_compressed/1024:.1f}KB of ~1400KB available")
-    if total_compressed > 1400 * 1024:
-        print("WARNING: Total exceeds SPIFFS capacity!")
+    print(f"Assets partition usage: {total_compressed/1024:.1f}KB of 1024KB")
+    if total_compressed > 1024 * 1024:
+        print("WARNING: Total exceeds the assets partition!")
         sys.exit(1)
 
 if __name__ == '__main__':